@@ -23,17 +23,27 @@
 
 // Include our modular header files
 #include "actuators.h"
+#include "alerts.h"
+#include "cloud.h"
 #include "config.h"
+#include "downlink.h"
+#include "health.h"
+#include "history.h"
+#include "log.h"
+#include "memory.h"
 #include "motor_control.h"
+#include "profile.h"
+#include "rates.h"
+#include "remote.h"
+#include "scheduler.h"
 #include "sensors.h"
+#include "telemetry.h"
 
 // Cloud integration variables
-struct ThingSpeakData {
-  float temp; float humid; int gas; int dist; 
-  int state; float pitch; float roll; float yaw;
-};
-ThingSpeakData receivedTSData;
-bool cloudConnected = false;
+CloudCache cloudCache; // Read-back fields and when each was heard
+unsigned long linkBaud = BAUD_RATE;  // Current serial rate
+bool baudSwitching = false;          // Waiting for BAUD_OK at the new rate
+unsigned long baudSwitchStart = 0;
 #define THINGSPEAK_MODE 5
 
 
@@ -41,214 +51,373 @@ bool cloudConnected = false;
 // GLOBAL VARIABLES
 // ==========================================
 
-unsigned long lastUpdateTime = 0;
-unsigned long lastDisplayUpdate = 0;
-unsigned long lastDHTUpdate = 0; // Separate timer for DHT sensor
 int displayMode = 0;
+bool warmingUp = false;          // IDLE -> ACTIVE warm-up in progress
+unsigned long warmUpStart = 0;
+#define WARM_UP_TIME 1000        // ms spent in IDLE after IR ON
 
 SensorData currentData;
+unsigned long loopCount = 0; // Debug counter
+
+// ==========================================
+// TASK TABLE
+// ==========================================
+// Order matters: tasks that are due in the same pass run top to bottom,
+// so sensors are read before alerts are evaluated on them.
+
+enum TaskId {
+  TASK_IR,        // IR remote + warm-up sequencing
+  TASK_SERIAL_RX, // Cloud handshake replies and ThingSpeak downlink
+  TASK_CLOUD,     // Cloud link state machine, heartbeats, reconnect
+  TASK_RANGING,   // Ultrasonic ping/echo, fast obstacle detection
+  TASK_IMU,       // MPU6050 FIFO drain and attitude fusion
+  TASK_GAS,       // MQ-2, re-checks the hazards on a change
+  TASK_STATE,     // Entry/exit actions of the last state change
+  TASK_SENSORS,   // DHT11
+  TASK_ALERTS,    // Environmental / obstacle / tilt thresholds, ALERT state
+  TASK_RATES,     // Sampling rates from the hazard rules (rates.h)
+  TASK_HISTORY,   // Sample history and window statistics
+  TASK_UPLINK,    // CSV or frame to the Python bridge
+  TASK_LIVE,      // Fast attitude/distance for the bridge's live dashboard
+  TASK_DISPLAY,   // LCD rotation
+  TASK_LCD_FLUSH, // Push changed framebuffer cells to the LCD
+  TASK_OUTPUTS,   // Pattern stepping on boards without the timer ISR
+  TASK_HEARTBEAT, // Debug "loop running" message
+  TASK_COUNT
+};
+
+// Task bodies are defined below loop()
+void taskIR();
+void taskSerialRx();
+void taskCloud();
+void taskRanging();
+void taskIMU();
+void taskGas();
+void taskState();
+void taskSensors();
+void taskAlerts();
+void taskRates();
+void taskHistory();
+void taskUplink();
+void taskLive();
+void taskDisplay();
+void taskLCDFlush();
+void taskOutputs();
+void taskHeartbeat();
+
+// Helpers the tasks call, also defined further down (declared here so
+// the sketch compiles as plain C++ for the host simulation in sim/)
+void handleIRRemote();
+void runRemoteCommand(uint8_t command);
+void sendDataToSerial(SensorData data);
+void sendLiveUpdate(const SensorData &data);
+bool isTilted(const SensorData &data);
+void connectToCloud();
+void runCloudAction(uint8_t action);
+void startBaudSwitch(unsigned long baud);
+void checkBaudTimeout();
+void readThingSpeakData();
+void applySampleRates();
+void displayThingSpeakData(int mode);
+void printCloudField(uint8_t field);
+
+// Sensor periods start at the CALM rates and follow rates.h from there
+//   run            period                       deadline
+Task tasks[TASK_COUNT] = {
+    {taskIR,        0,                           0,    0, 0},
+    {taskSerialRx,  0,                           0,    0, 0},
+    {taskCloud,     CLOUD_TICK,                  50,   0, 0},
+    {taskRanging,   RATE_CALM_MS(RATE_RANGING),  20,   0, 0},
+    {taskIMU,       RATE_CALM_MS(RATE_IMU),      5,    0, 0},
+    {taskGas,       RATE_CALM_MS(RATE_GAS),      20,   0, 0},
+    {taskState,     0,                           0,    0, 0},
+    {taskSensors,   RATE_CALM_MS(RATE_CLIMATE),  100,  0, 0},
+    {taskAlerts,    2000,                        100,  0, 0},
+    {taskRates,     RATE_UPDATE_INTERVAL,        20,   0, 0},
+    {taskHistory,   HISTORY_INTERVAL,            100,  0, 0},
+    {taskUplink,    UPDATE_INTERVAL,             500,  0, 0},
+    {taskLive,      LIVE_INTERVAL,               50,   0, 0},
+    {taskDisplay,   10000,                       500,  0, 0},
+    {taskLCDFlush,  LCD_FLUSH_INTERVAL,          5,    0, 0},
+    {taskOutputs,   0,                           0,    0, 0},
+    {taskHeartbeat, 5000,                        1000, 0, 0},
+};
+
+static_assert(1 + TASK_COUNT * 2 <= FRAME_MAX_PAYLOAD,
+              "STATS_TASKS sends a uint16 per task");
 
 // ==========================================
 // SETUP
 // ==========================================
 
 void setup() {
+  paintStack(); // For the stack low-water mark (memory.h)
+  stopWatchdog(); // Still running if it caused this reset (health.h)
+
   // Initialize Serial communication
   Serial.begin(BAUD_RATE);
-  Serial.println(F("=============================="));
-  Serial.println(F(" Disaster Recon UAV Starting"));
-  Serial.println(F("=============================="));
+  LOG_INFO(LOG_TAG_SYS, F("Disaster Recon UAV Starting"));
 
   // Initialize LCD first for user feedback
   initializeLCD();
   delay(2000);
 
   // Initialize all components
-  Serial.println(F("Initializing sensors..."));
+  LOG_INFO(LOG_TAG_SYS, F("Initializing sensors..."));
   initializeSensors();
 
-  Serial.println(F("Initializing actuators..."));
+  LOG_INFO(LOG_TAG_SYS, F("Initializing actuators..."));
   initializeRGB();
   initializeBuzzer();
+  initializePatterns();
 
-  Serial.println(F("Initializing motor..."));
+  LOG_INFO(LOG_TAG_SYS, F("Initializing motor..."));
   initializeMotor();
 
-  Serial.println(F("Initializing IR receiver..."));
-  IrReceiver.begin(IR_PIN, ENABLE_LED_FEEDBACK); // Start IR receiver
+  LOG_INFO(LOG_TAG_SYS, F("Initializing IR receiver..."));
+  initializeRemote();
 
   // Ready signal
   beepReady(); // Short beep when ready
   displayReady();
   rgbPurple();
 
-  Serial.println(F("System ready! Waiting for IR ON command..."));
-  Serial.println(F(""));
+  LOG_INFO(LOG_TAG_SYS, F("System ready! Waiting for IR ON command..."));
+  LOG_INFO(LOG_TAG_SYS, F("Free RAM (bytes): "), (long)freeRam());
+  startWatchdog(); // A hung pass resets the board now (health.h)
+  logWaitForRoom = false; // From here on logs never block the tasks
 }
 
 // ==========================================
 // MAIN LOOP
 // ==========================================
 
-unsigned long loopCount = 0; // Debug counter
-
 void loop() {
-  // Debug: Print every 100 loops to confirm loop is running
   loopCount++;
-  if (loopCount % 100 == 0) {
-    Serial.print(F("Loop running... count: "));
-    Serial.println(loopCount);
-  }
+  profileLoop();
+
+  // Every task is non-blocking, so this spins as fast as the tasks allow
+  runTasks(tasks, TASK_COUNT);
+}
+
+// ==========================================
+// TASKS
+// ==========================================
 
+void taskIR() {
   // Check for IR remote commands
   handleIRRemote();
 
-  // If UAV is ON, collect and transmit data
-  if (currentState != STATE_OFF) {
-    // Check if it's time to update sensors
-    unsigned long currentTime = millis();
-    
-    // Check for cloud data if connected
-    if (cloudConnected) {
-      readThingSpeakData();
+  // Finish the IDLE warm-up without blocking
+  if (warmingUp && millis() - warmUpStart >= WARM_UP_TIME) {
+    warmingUp = false;
+    if (stateEvent(EVENT_WARMED_UP)) {
+      // Connect to cloud, from the next cloud task step on
+      startCloud(cloud, millis());
+      triggerTask(tasks[TASK_CLOUD]);
+
+      // A hazard left over from warm-up raises ALERT straight away
+      triggerTask(tasks[TASK_ALERTS]);
     }
-    // Update DHT sensor more frequently (every 2 seconds for real-time display)
-    if (currentTime - lastDHTUpdate >= 2000) {
-      lastDHTUpdate = currentTime;
-      currentData.temperature = readTemperature();
-      currentData.humidity = readHumidity();
-
-      // Update distance and MPU every 2 seconds for obstacle detection
-      currentData.distance = readDistance();
-      updateMPU();
-      currentData.pitch = readPitch();
-      currentData.roll = readRoll();
-      currentData.yaw = readYaw();
-
-      // ========================================
-      // ENVIRONMENTAL THRESHOLD DETECTION
-      // ========================================
-
-      // Priority 1: Check for FIRE (Temperature ≥ 30°C)
-      if (currentData.temperature >= 30) {
-        lcd.clear();
-        lcd.print(F("FIRE DETECTED!"));
-        lcd.setCursor(0, 1);
-        lcd.print(F("Temp: "));
-        lcd.print(currentData.temperature, 1);
-        lcd.print(F("C"));
-        beepEnvironmental(); // Beeep Beeep Beeep
-        rgbOrange();
-        delay(100);
-        rgbOff();
-      }
-      // Priority 2: Check for COLD/BLIZZARD (Temperature ≤ 20°C)
-      else if (currentData.temperature <= 20) {
-        lcd.clear();
-        lcd.print(F("BLIZZARD!"));
-        lcd.setCursor(0, 1);
-        lcd.print(F("Temp: "));
-        lcd.print(currentData.temperature, 1);
-        lcd.print(F("C"));
-        beepEnvironmental(); // Beeep Beeep Beeep
-        rgbCyan();
-        delay(100);
-        rgbOff();
-      }
-      // Priority 3: Check for HURRICANE (Humidity 99-120%)
-      else if (currentData.humidity >= 99 && currentData.humidity <= 120) {
-        lcd.clear();
-        lcd.print(F("HURRICANE!"));
-        lcd.setCursor(0, 1);
-        lcd.print(F("Humid: "));
-        lcd.print(currentData.humidity, 0);
-        lcd.print(F("%"));
-        beepEnvironmental(); // Beeep Beeep Beeep
-        rgbDeepBlue();
-        delay(100);
-        rgbOff();
-      }
-      // Priority 4: Check for GAS
-      else if (isHazardousGas(currentData.gasLevel)) {
-        lcd.clear();
-        lcd.print(F("GAS DETECTED!"));
-        lcd.setCursor(0, 1);
-        lcd.print(F("Level: "));
-        lcd.print(currentData.gasLevel);
-        beepEnvironmental(); // Beeep Beeep Beeep
-        rgbYellow();
-        delay(100);
-        rgbOff();
-      }
-      // Priority 5: Check for obstacles (distance < 5cm)
-      else if (currentData.distance > 0 && currentData.distance < 5) {
-        lcd.clear();
-        lcd.print(F("OBSTACLE!"));
-        lcd.setCursor(0, 1);
-        lcd.print(F("Pulling up..."));
-        beepObstacle(); // 5 short bursts
-        rgbRed();
-        delay(50);
-        rgbOff();
-      }
-      // Priority 6: Check for excessive tilt (MPU)
-      else if (abs(currentData.pitch) > 45 || abs(currentData.roll) > 45) {
-        lcd.clear();
-        lcd.print(F("TILT ALERT!"));
-        lcd.setCursor(0, 1);
-        lcd.print(F("Leveling..."));
-        beepObstacle(); // 5 short bursts
-        rgbRed();
-        delay(50);
-        rgbOff();
-      }
+  }
+}
+
+void taskSerialRx() {
+  // Bridge replies and cloud data share the same parser
+  readThingSpeakData();
+
+  if (baudSwitching) {
+    checkBaudTimeout();
+  }
+
+  // Profiler pages, history frames and window lines go out one per
+  // pass as TX room allows
+  serviceStats(tasks, TASK_COUNT);
+  serviceHistory();
+#if !TELEMETRY_BINARY
+  serviceWindowLines();
+#endif
+}
+
+// Ping at the ranging rate; a new obstacle runs the alerts right away
+void taskRanging() {
+  if (currentState == STATE_OFF) {
+    return;
+  }
+
+  if (updateRanging()) {
+    bool wasObstacle = currentData.distance > 0 &&
+                       currentData.distance < OBSTACLE_DISTANCE;
+    currentData.distance = readDistance();
+    bool isObstacle = currentData.distance > 0 &&
+                      currentData.distance < OBSTACLE_DISTANCE;
+    if (isObstacle && !wasObstacle) {
+      triggerTask(tasks[TASK_ALERTS]);
     }
+  }
+}
+
+// Drain and fuse the MPU FIFO; a new tilt runs the alerts right away
+void taskIMU() {
+  if (currentState == STATE_OFF || !updateMPU()) {
+    return;
+  }
+
+  bool wasTilted = isTilted(currentData);
+  currentData.pitch = readPitch();
+  currentData.roll = readRoll();
+  currentData.yaw = readYaw();
+  motorAttitude(currentData.pitch, currentData.roll); // Closed-loop hook
+  if (isTilted(currentData) && !wasTilted) {
+    triggerTask(tasks[TASK_ALERTS]);
+  }
+}
 
-    // Update sensors and send data every UPDATE_INTERVAL (15 seconds)
-    if (currentTime - lastUpdateTime >= UPDATE_INTERVAL) {
-      lastUpdateTime = currentTime;
+// Read the MQ-2 at the gas rate; the alerts (and so the state) follow
+// a new hazard right away, and every read re-checks them during ALERT
+void taskGas() {
+  if (currentState == STATE_OFF) {
+    return;
+  }
 
-      // Read gas sensor
-      currentData.gasLevel = readGasLevel();
+  bool wasHazard = isHazardousGas(currentData.gasLevel);
+  currentData.gasLevel = readGasLevel();
+  if (isHazardousGas(currentData.gasLevel) != wasHazard ||
+      currentState == STATE_ALERT) {
+    triggerTask(tasks[TASK_ALERTS]);
+  }
+}
 
-      // Update state based on sensor readings
-      updateState(currentData);
+// Entry/exit actions queued by the last state change (motor_control.h)
+void taskState() { runStateActions(); }
 
-      // Send data to Serial (for Python to upload to ThingSpeak)
-      sendDataToSerial(currentData);
+// Update DHT at the climate rate for real-time display (a DHT11 that
+// is down is only retried after its backoff, see health.h)
+void taskSensors() {
+  if (currentState == STATE_OFF) {
+    return;
+  }
 
-      // Brief flash to indicate data transmission
-      rgbBlue();
-      delay(200);
+  PROFILE_SCOPE(PROF_DHT);
 
-      // Restore state color
-      if (currentState == STATE_ACTIVE)
-        rgbGreen();
-      else if (currentState == STATE_ALERT)
-        rgbRed();
-    }
+  readClimate(currentData);
+}
 
-    // Update LCD display (rotate every 10 seconds)
-    if (currentTime - lastDisplayUpdate >= 10000) {
-      lastDisplayUpdate = currentTime;
-
-      if (currentState == STATE_ACTIVE) {
-        displayMode++;
-        if (displayMode > THINGSPEAK_MODE) {
-          displayMode = 0;
-        }
-        
-        if (displayMode == THINGSPEAK_MODE && cloudConnected) {
-          displayThingSpeakData(0);
-        } else {
-          displaySensorData(currentData, displayMode);
-        }
-      }
-    }
+bool isTilted(const SensorData &data) {
+  return abs(data.pitch) > TENTHS(TILT_LIMIT) ||
+         abs(data.roll) > TENTHS(TILT_LIMIT);
+}
+
+// ========================================
+// ENVIRONMENTAL THRESHOLD DETECTION
+// ========================================
+// The rules live in alerts.h. Alerts fire once when they start; the
+// buzzer and LED patterns are played in the background by the pattern
+// engine's timer interrupt.
+
+void taskAlerts() {
+  if (currentState == STATE_OFF) {
+    resetHazards(); // Re-announce anything still present after power on
+    return;
+  }
+
+  QuantizedSample sample;
+  quantizeSample(currentData, currentState, sample);
+  if (evaluateHazards(sample)) {
+    triggerTask(tasks[TASK_DISPLAY]); // All clear, back to the readings
+  }
+  updateState(stateHazardActive());
+}
+
+// Speed sensors up near their hazard limits, slow them down when calm
+void taskRates() {
+  if (currentState == STATE_OFF) {
+    return;
+  }
+
+  QuantizedSample sample;
+  quantizeSample(currentData, currentState, sample);
+  if (updateRateLevels(sample, currentState)) {
+    applySampleRates();
+  }
+}
+
+void applySampleRates() {
+  tasks[TASK_GAS].periodMs = sampleInterval(RATE_SENSOR_GAS);
+  tasks[TASK_RANGING].periodMs = sampleInterval(RATE_SENSOR_RANGING);
+  tasks[TASK_IMU].periodMs = sampleInterval(RATE_SENSOR_IMU);
+  tasks[TASK_SENSORS].periodMs = sampleInterval(RATE_SENSOR_CLIMATE);
+}
+
+// Keep every HISTORY_INTERVAL sample for the window statistics
+void taskHistory() {
+  if (currentState == STATE_OFF) {
+    return;
+  }
+
+  recordSample(currentData, currentState);
+
+  // Report every WINDOW_SAMPLES samples
+  if (windowSamples >= WINDOW_SAMPLES) {
+#if TELEMETRY_BINARY
+    // TX buffer full: the window keeps growing and the next pass tries
+    // again (it restarts at WINDOW_MAX_SAMPLES)
+    sendWindowFrame();
+#else
+    startWindowLines(); // Printed from the serial task as TX room allows
+#endif
+  }
+}
+
+// Send the latest readings every UPDATE_INTERVAL (2 seconds)
+void taskUplink() {
+  if (currentState == STATE_OFF) {
+    return;
+  }
+
+  // Send data to Serial (for Python to upload to ThingSpeak)
+  sendDataToSerial(currentData);
+
+  // Brief flash to indicate data transmission (state color comes back after)
+  playPattern(PATTERN_UPLINK);
+}
+
+// Attitude and distance every LIVE_INTERVAL, between the full samples:
+// the bridge shows them on its live dashboard and doesn't upload them
+void taskLive() {
+  if (!LIVE_ENABLED || currentState == STATE_OFF) {
+    return;
+  }
+  sendLiveUpdate(currentData);
+}
+
+// Update LCD display (rotate every 10 seconds, held while an alert shows)
+void taskDisplay() {
+  if (currentState != STATE_ACTIVE || hazardOnScreen()) {
+    return;
   }
 
-  // Small delay for stability
-  delay(50);
+  displayMode++;
+  if (displayMode > THINGSPEAK_MODE) {
+    displayMode = 0;
+  }
+
+  if (displayMode == THINGSPEAK_MODE && cloudLinkUp(cloud)) {
+    displayThingSpeakData(0);
+  } else {
+    displaySensorData(currentData, displayMode);
+  }
+}
+
+void taskLCDFlush() { updateLCD(); }
+
+// Patterns run from a timer interrupt on AVR; this only steps them on
+// boards without one
+void taskOutputs() { updatePatterns(); }
+
+void taskHeartbeat() {
+  // Debug: confirm loop is running (count is passes since boot)
+  LOG_DEBUG(LOG_TAG_SYS, F("Loop running... count: "), (long)loopCount);
 }
 
 // ==========================================
@@ -256,51 +425,83 @@ void loop() {
 // ==========================================
 
 void handleIRRemote() {
-  // Check if IR data is available
-  if (IrReceiver.decode()) {
-    unsigned long irCode = IrReceiver.decodedIRData.decodedRawData;
-
-    // Ignore repeat codes (0x0) - only process actual button codes
-    if (irCode != 0x0) {
-      Serial.println(F("=== IR SIGNAL DETECTED ==="));
-      Serial.print(F("IR Code received: 0x"));
-      Serial.println(irCode, HEX);
-
-      beepIR(); // Short beep for IR button press
-
-      // SIMPLIFIED: ANY button toggles UAV ON/OFF
-      if (currentState == STATE_OFF) {
-        // Turn ON
-        Serial.println(F("IR: Turning UAV ON"));
-        setState(STATE_IDLE);
-        delay(1000); // Brief warm-up period
-        setState(STATE_ACTIVE);
-        
-        // Connect to cloud
-        connectToCloud();
-      } else {
-        // Turn OFF
-        Serial.println(F("IR: Turning UAV OFF"));
-        cloudConnected = false;
-        setState(STATE_OFF);
-      }
+  PROFILE_SCOPE(PROF_IR);
+
+  // Codes queued by the receive interrupt (remote.h), oldest first
+  uint32_t irCode;
+  while (popIRCode(irCode)) {
+    uint8_t command = lookupRemoteCommand(irCode);
+    if (command == CMD_NONE) {
+      LOG_INFO(LOG_TAG_IR, F("Unmapped IR code ignored: 0x"), LOG_HEX(irCode));
+      continue;
+    }
+
+    LOG_INFO(LOG_TAG_IR, F("IR Code received: 0x"), LOG_HEX(irCode));
+    beepIR(); // Short beep for IR button press
+    runRemoteCommand(command);
+  }
+
+  noInterrupts(); // The IR ISR may be counting another one
+  uint8_t dropped = irQueueDropped;
+  irQueueDropped = 0;
+  interrupts();
+  if (dropped) {
+    LOG_WARN(LOG_TAG_IR, F("IR presses dropped (queue full): "), (long)dropped);
+  }
+}
+
+// Each command is a state change plus flags; nothing here waits
+void runRemoteCommand(uint8_t command) {
+  switch (command) {
+  case CMD_POWER_ON:
+    if (!stateEvent(EVENT_POWER_ON)) {
+      return; // Already on
     }
+    LOG_INFO(LOG_TAG_IR, F("Turning UAV ON"));
 
-    IrReceiver.resume(); // Enable receiving of the next value
+    // Brief warm-up period, finished by taskIR()
+    warmingUp = true;
+    warmUpStart = millis();
+
+    // Slow sensors read now, before the first alert check
+    triggerTask(tasks[TASK_GAS]);
+    triggerTask(tasks[TASK_SENSORS]);
+    break;
+
+  case CMD_POWER_OFF:
+    if (!stateEvent(EVENT_POWER_OFF)) {
+      return; // Already off
+    }
+    LOG_INFO(LOG_TAG_IR, F("Turning UAV OFF"));
+    warmingUp = false;
+    stopCloud(cloud, millis());
+    break;
   }
 }
 
 // ==========================================
-// SEND DATA TO SERIAL (CSV FORMAT)
+// SEND DATA TO SERIAL (CSV OR BINARY FRAME)
 // ==========================================
 
 void sendDataToSerial(SensorData data) {
+  PROFILE_SCOPE(PROF_UPLINK);
+
+#if TELEMETRY_BINARY
+  // Packed frame, see telemetry.h (decoded by telemetry_protocol.py)
+  QuantizedSample sample;
+  quantizeSample(data, currentState, sample);
+#if TELEMETRY_DELTA
+  sendDeltaTelemetry(sample);
+#else
+  sendTelemetryFrame(sample);
+#endif
+#else
   // Send CSV formatted data for Python script
-  // Format: temp,humid,gas,dist,state,pitch,roll,yaw
+  // Format: temp,humid,gas,dist,state,pitch,roll,yaw,device,health
 
-  Serial.print(data.temperature, 1);
+  printTenths(Serial, data.temperature);
   Serial.print(F(","));
-  Serial.print(data.humidity, 1);
+  printTenths(Serial, data.humidity);
   Serial.print(F(","));
   Serial.print(data.gasLevel);
   Serial.print(F(","));
@@ -308,129 +509,254 @@ void sendDataToSerial(SensorData data) {
   Serial.print(F(","));
   Serial.print(currentState);
   Serial.print(F(","));
-  Serial.print(data.pitch, 1);
+  printTenths(Serial, data.pitch);
+  Serial.print(F(","));
+  printTenths(Serial, data.roll);
   Serial.print(F(","));
-  Serial.print(data.roll, 1);
+  printTenths(Serial, data.yaw);
   Serial.print(F(","));
-  Serial.println(data.yaw, 1); // println for newline at end
+  Serial.print(DEVICE_ID);
+  Serial.print(F(","));
+  Serial.println(healthFlags); // println for newline at end
+#endif
 }
 
+// Live update, as a frame or a text line like the samples:
+//   LIVE:pitch,roll,yaw,distance,device
+#define LIVE_LINE_MAX 37 // Longest line, "\r\n" included
+
+void sendLiveUpdate(const SensorData &data) {
+#if TELEMETRY_BINARY
+  sendLiveFrame(data);
+#else
+  if (Serial.availableForWrite() < LIVE_LINE_MAX) {
+    return; // Busy: the next one is LIVE_INTERVAL away
+  }
+  Serial.print(F("LIVE:"));
+  printTenths(Serial, data.pitch);
+  Serial.print(F(","));
+  printTenths(Serial, data.roll);
+  Serial.print(F(","));
+  printTenths(Serial, data.yaw);
+  Serial.print(F(","));
+  Serial.print(data.distance);
+  Serial.print(F(","));
+  Serial.println(DEVICE_ID);
+#endif
+}
+
+
+// Step the cloud link (cloud.h); replies arrive through the serial RX task
+void taskCloud() { runCloudAction(stepCloud(cloud, millis())); }
 
-// Cloud connection function
+// Cloud connection: send the request, the reply is picked up by
+// readThingSpeakData() from the serial RX task
 void connectToCloud() {
-  lcd.clear();
-  lcd.print(F("Connecting to"));
-  lcd.setCursor(0, 1);
-  lcd.print(F("cloud..."));
-  Serial.println("CONNECT_CLOUD");
-  
-  unsigned long startTime = millis();
-  while (millis() - startTime < 5000) {
-    if (Serial.available()) {
-      String response = Serial.readStringUntil('\n');
-      if (response == "CLOUD_OK") {
-        cloudConnected = true;
-        lcd.clear();
-        lcd.print(F("Connected!"));
-        beepReady();
-        delay(2000);
-        return;
-      } else if (response == "CLOUD_FAIL") {
-        cloudConnected = false;
-        lcd.clear();
-        lcd.print(F("Connection"));
-        lcd.setCursor(0, 1);
-        lcd.print(F("failed!"));
-        delay(2000);
-        return;
+  if (cloud.failures == 0) {
+    // Only the first attempt takes over the LCD
+    screen.clear();
+    screen.print(F("Connecting to"));
+    screen.setCursor(0, 1);
+    screen.print(F("cloud..."));
+  }
+  // Offer a faster link; the bridge answers CLOUD_OK:<rate> (or plain
+  // CLOUD_OK to stay at BAUD_RATE)
+  Serial.print(F("CONNECT_CLOUD:"));
+  Serial.println(BAUD_RATE_MAX);
+}
+
+// Carry out what the cloud state machine asked for
+void runCloudAction(uint8_t action) {
+  switch (action) {
+  case CLOUD_SEND_CONNECT:
+    connectToCloud();
+    break;
+
+  case CLOUD_SEND_PING:
+    Serial.println(F("PING"));
+    break;
+
+  case CLOUD_LINK_UP:
+    LOG_INFO(LOG_TAG_LINK, F("Cloud link up"));
+    screen.clear();
+    screen.print(F("Connected!"));
+    beepReady();
+    deferTask(tasks[TASK_DISPLAY]); // Keep the message up for a while
+    break;
+
+  case CLOUD_REJECTED:
+  case CLOUD_TIMED_OUT:
+    LOG_WARN(LOG_TAG_LINK, F("Cloud connect failed, retry in ms: "),
+             (long)(cloud.retryAt - millis()));
+    if (cloud.failures == 1) {
+      screen.clear();
+      if (action == CLOUD_REJECTED) {
+        screen.print(F("Connection"));
+        screen.setCursor(0, 1);
+        screen.print(F("failed!"));
+      } else {
+        screen.print(F("Timeout!"));
       }
+      deferTask(tasks[TASK_DISPLAY]);
     }
-    delay(100);
+    break;
+
+  case CLOUD_LINK_QUIET:
+    LOG_WARN(LOG_TAG_LINK, F("Cloud link quiet, degraded"));
+    break;
+
+  case CLOUD_LINK_LOST:
+    // The bridge may have restarted at the boot rate
+    LOG_WARN(LOG_TAG_LINK, F("Cloud link lost, reconnecting"));
+    if (linkBaud != BAUD_RATE) {
+      baudSwitching = false;
+      Serial.flush();
+      Serial.begin(BAUD_RATE);
+      linkBaud = BAUD_RATE;
+    }
+    break;
   }
-  cloudConnected = false;
-  lcd.clear();
-  lcd.print(F("Timeout!"));
-  delay(2000);
 }
 
-// Read ThingSpeak data from serial
-void readThingSpeakData() {
-  static String receivedString = "";
-  static boolean newData = false;
-  
-  while (Serial.available()) {
-    char inChar = (char)Serial.read();
-    if (inChar == '\n') {
-      newData = true;
-      break;
+// Handle a keyword line from the Python bridge
+void handleBridgeKeyword(const char *keyword) {
+  if (strcmp_P(keyword, PSTR("STATS")) == 0) {
+    requestStats();
+    return;
+  }
+
+  if (strcmp_P(keyword, PSTR("HISTORY")) == 0) {
+    requestHistory();
+    return;
+  }
+
+  if (strcmp_P(keyword, PSTR("BAUD_OK")) == 0) {
+    if (baudSwitching) {
+      baudSwitching = false; // Bridge heard us at the new rate
+      LOG_INFO(LOG_TAG_LINK, F("Link baud rate: "), (long)linkBaud);
     }
-    if (isDigit(inChar) || inChar == '.' || inChar == '-' || inChar == '|') {
-      receivedString += inChar;
+    return;
+  }
+
+  if (strcmp_P(keyword, PSTR("PONG")) == 0) {
+    return; // Heartbeat reply, cloudHeard() already noted it
+  }
+
+  if (strncmp_P(keyword, PSTR("CLOUD_OK"), 8) == 0 &&
+      (keyword[8] == '\0' || keyword[8] == ':')) {
+    uint8_t action = cloudReply(cloud, millis(), true);
+    if (action == CLOUD_LINK_UP && keyword[8] == ':') {
+      startBaudSwitch(strtoul(keyword + 9, NULL, 10));
     }
+    runCloudAction(action);
+  } else if (strcmp_P(keyword, PSTR("CLOUD_FAIL")) == 0) {
+    runCloudAction(cloudReply(cloud, millis(), false));
   }
-  
-  if (newData) {
-    char tempStr[receivedString.length() + 1];
-    receivedString.toCharArray(tempStr, sizeof(tempStr));
-    char *token = strtok(tempStr, "|");
-    int fieldIndex = 0;
-    
-    while (token != NULL) {
-      float value = atof(token);
-      switch (fieldIndex) {
-        case 0: receivedTSData.temp = value; break;
-        case 1: receivedTSData.humid = value; break;
-        case 2: receivedTSData.gas = (int)value; break;
-        case 3: receivedTSData.dist = (int)value; break;
-        case 4: receivedTSData.state = (int)value; break;
-        case 5: receivedTSData.pitch = value; break;
-        case 6: receivedTSData.roll = value; break;
-        case 7: receivedTSData.yaw = value; break;
+}
+
+// Switch to the rate the bridge picked. Both sides revert to BAUD_RATE
+// unless BAUD_CHECK / BAUD_OK make it across at the new rate.
+void startBaudSwitch(unsigned long baud) {
+  if (baud == linkBaud || baud < BAUD_RATE || baud > BAUD_RATE_MAX) {
+    return;
+  }
+
+  Serial.flush(); // Let pending TX finish at the old rate
+  Serial.begin(baud);
+  linkBaud = baud;
+  baudSwitching = true;
+  baudSwitchStart = millis();
+  Serial.println(F("BAUD_CHECK"));
+}
+
+void checkBaudTimeout() {
+  if (millis() - baudSwitchStart >= BAUD_SWITCH_TIMEOUT) {
+    baudSwitching = false;
+    Serial.flush();
+    Serial.begin(BAUD_RATE);
+    linkBaud = BAUD_RATE;
+    LOG_WARN(LOG_TAG_LINK, F("Baud switch failed, staying at fallback rate"));
+  }
+}
+
+// Read ThingSpeak data and bridge replies from serial
+void readThingSpeakData() {
+  while (Serial.available()) {
+    switch (feedDownlink(downlink, (char)Serial.read())) {
+    case DOWNLINK_KEYWORD:
+      runCloudAction(cloudHeard(cloud, millis()));
+      handleBridgeKeyword(downlink.keyword);
+      break;
+
+    case DOWNLINK_DATA:
+      runCloudAction(cloudHeard(cloud, millis()));
+      // Only accept cloud data while connected
+      if (cloudLinkUp(cloud) && currentState != STATE_OFF) {
+        storeCloudData(downlink, cloudCache, millis());
       }
-      fieldIndex++;
-      token = strtok(NULL, "|");
+      break;
     }
-    receivedString = "";
-    newData = false;
   }
 }
 
 // Display ThingSpeak cloud data
 void displayThingSpeakData(int mode) {
   static int tsDisplayStep = 0;
-  lcd.clear();
-  lcd.setCursor(0, 0);
+  screen.clear();
+  screen.setCursor(0, 0);
   
   if (tsDisplayStep == 0) {
-    lcd.print(F("Cloud T/H: "));
-    lcd.print(receivedTSData.temp, 1);
-    lcd.setCursor(0, 1);
-    lcd.print(receivedTSData.humid, 0);
-    lcd.print(F("%"));
+    screen.print(F("Cloud T/H: "));
+    printCloudField(FIELD_TEMPERATURE);
+    screen.setCursor(0, 1);
+    printCloudField(FIELD_HUMIDITY);
+    screen.print(F("%"));
   }
   else if (tsDisplayStep == 1) {
-    lcd.print(F("Cloud Gas: "));
-    lcd.print(receivedTSData.gas);
-    lcd.setCursor(0, 1);
-    lcd.print(F("Dist: "));
-    lcd.print(receivedTSData.dist);
-    lcd.print(F("cm"));
+    screen.print(F("Cloud Gas: "));
+    printCloudField(FIELD_GAS);
+    screen.setCursor(0, 1);
+    screen.print(F("Dist: "));
+    printCloudField(FIELD_DISTANCE);
+    screen.print(F("cm"));
   }
   else if (tsDisplayStep == 2) {
-    lcd.print(F("Cloud P/R: "));
-    lcd.print(receivedTSData.pitch, 0);
-    lcd.setCursor(0, 1);
-    lcd.print(receivedTSData.roll, 0);
-    lcd.print(F(" deg"));
+    screen.print(F("Cloud P/R: "));
+    printCloudField(FIELD_PITCH);
+    screen.setCursor(0, 1);
+    printCloudField(FIELD_ROLL);
+    screen.print(F(" deg"));
   }
   else if (tsDisplayStep == 3) {
-    lcd.print(F("Cloud Yaw: "));
-    lcd.print(receivedTSData.yaw, 0);
-    lcd.setCursor(0, 1);
-    lcd.print(F("State: "));
-    lcd.print(receivedTSData.state);
+    screen.print(F("Cloud Yaw: "));
+    printCloudField(FIELD_YAW);
+    screen.setCursor(0, 1);
+    screen.print(F("State: "));
+    printCloudField(WIRE_STATE);
   }
   
   tsDisplayStep++;
   if (tsDisplayStep > 3) tsDisplayStep = 0;
 }
+
+// One read-back field (wire order) in its display units: "--" for a
+// read error, "*" after a value the bridge hasn't confirmed lately
+void printCloudField(uint8_t field) {
+  int16_t value = field == WIRE_STATE ? cloudCache.sample.state
+                                      : cloudCache.sample.field[field];
+  if (value == SAMPLE_INVALID) {
+    screen.print(F("--"));
+  } else if (field == FIELD_TEMPERATURE) {
+    printTenths(screen, value);
+  } else if (field == FIELD_HUMIDITY) {
+    printTenths(screen, value * 5, false); // 0.5 % to whole percent
+  } else if (field == FIELD_GAS || field == FIELD_DISTANCE ||
+             field == WIRE_STATE) {
+    screen.print(value);
+  } else {
+    printTenths(screen, value, false); // Angles, whole degrees
+  }
+  if (!cloudFieldFresh(cloudCache, field, millis())) {
+    screen.print('*');
+  }
+}
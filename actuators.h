@@ -2,7 +2,7 @@
  * Actuator Functions for Disaster Recon UAV
  *
  * Controls all output devices:
- * - LCD Display (I2C 16x2)
+ * - LCD Display (I2C 16x2, drawn through a RAM framebuffer)
  * - RGB LED (status indicator)
  * - Piezo Buzzer (alerts)
  */
@@ -11,23 +11,120 @@
 #define ACTUATORS_H
 
 #include "config.h"  // For LCD_ADDRESS, RGB pins, buzzer constants
+#include "fixed.h"
+#include "profile.h"
 #include "sensors.h" // For SensorData type
 #include <LiquidCrystal_I2C.h>
 
 // Global LCD object
 LiquidCrystal_I2C lcd(LCD_ADDRESS, LCD_COLS, LCD_ROWS);
 
+// ==========================================
+// LCD FRAMEBUFFER
+// ==========================================
+// Display code draws into `screen` (same print/setCursor/clear calls
+// as the LCD, but into RAM). flush() compares it with what the LCD
+// already shows and sends only the changed cells, a few per call, so
+// a screen update never waits on lcd.clear() or a full 32-cell I2C
+// rewrite.
+
+#define LCD_NO_CURSOR 0xFF
+
+class LcdFrame : public Print {
+public:
+  char cells[LCD_ROWS][LCD_COLS]; // Frame being drawn
+  char sent[LCD_ROWS][LCD_COLS];  // What the LCD currently shows
+  uint8_t col = 0;
+  uint8_t row = 0;
+  uint8_t lcdCursor = LCD_NO_CURSOR; // Hardware cursor (row * COLS + col)
+  bool backlightOn = false;
+
+  using Print::write;
+
+  size_t write(uint8_t c) override {
+    if (col < LCD_COLS && row < LCD_ROWS) {
+      cells[row][col++] = c;
+    }
+    return 1;
+  }
+
+  void clear() {
+    memset(cells, ' ', sizeof(cells));
+    col = 0;
+    row = 0;
+  }
+
+  void setCursor(uint8_t newCol, uint8_t newRow) {
+    col = newCol;
+    row = newRow;
+  }
+
+  // Only talks to the LCD when the backlight is actually off
+  void backlight() {
+    if (!backlightOn) {
+      lcd.backlight();
+      backlightOn = true;
+    }
+  }
+
+  // The LCD was just cleared by hand
+  void resetSent() {
+    memset(sent, ' ', sizeof(sent));
+    lcdCursor = 0;
+  }
+
+  bool isDirty() const { return memcmp(cells, sent, sizeof(cells)) != 0; }
+
+  // Send up to maxCells changed cells; returns how many were sent
+  uint8_t flush(uint8_t maxCells) {
+    uint8_t written = 0;
+    for (uint8_t r = 0; r < LCD_ROWS; r++) {
+      for (uint8_t c = 0; c < LCD_COLS; c++) {
+        if (cells[r][c] == sent[r][c]) {
+          continue;
+        }
+        if (written == maxCells) {
+          return written;
+        }
+
+        uint8_t index = r * LCD_COLS + c;
+        if (lcdCursor != index) {
+          lcd.setCursor(c, r);
+        }
+        lcd.write(cells[r][c]);
+        sent[r][c] = cells[r][c];
+        written++;
+
+        // The LCD auto-increments, but not from one row to the next
+        lcdCursor = (c + 1 < LCD_COLS) ? index + 1 : LCD_NO_CURSOR;
+      }
+    }
+    return written;
+  }
+};
+
+LcdFrame screen;
+
+// Called by the scheduler
+void updateLCD() {
+  PROFILE_SCOPE(PROF_LCD);
+  screen.flush(LCD_FLUSH_CELLS);
+}
+
 // ==========================================
 // LCD INITIALIZATION
 // ==========================================
 
 void initializeLCD() {
   lcd.init();
-  lcd.backlight();
   lcd.clear();
-  lcd.print(F("UAV Initializing"));
-  lcd.setCursor(0, 1);
-  lcd.print(F("Please wait..."));
+  screen.resetSent();
+  screen.backlight();
+  screen.clear();
+  screen.print(F("UAV Initializing"));
+  screen.setCursor(0, 1);
+  screen.print(F("Please wait..."));
+  screen.flush(LCD_ROWS * LCD_COLS); // Loop isn't running yet
 }
 
 // ==========================================
@@ -35,179 +132,395 @@ void initializeLCD() {
 // ==========================================
 
 void displayReady() {
-  lcd.backlight();
-  lcd.clear();
-  lcd.print(F("Ready to Fly!"));
-  lcd.setCursor(0, 1);
-  lcd.print(F("Press IR ON"));
+  screen.backlight();
+  screen.clear();
+  screen.print(F("Ready to Fly!"));
+  screen.setCursor(0, 1);
+  screen.print(F("Press IR ON"));
 }
 
 void displayOff() {
-  lcd.backlight();
-  lcd.clear();
-  lcd.print(F("UAV OFF"));
-  lcd.setCursor(0, 1);
-  lcd.print(F("Standby Mode"));
+  screen.backlight();
+  screen.clear();
+  screen.print(F("UAV OFF"));
+  screen.setCursor(0, 1);
+  screen.print(F("Standby Mode"));
 }
 
 void displaySensorData(SensorData data, int displayMode) {
-  lcd.backlight();
-  lcd.clear();
+  screen.backlight();
+  screen.clear();
 
   // Rotate display between different sensor readings
   switch (displayMode % 4) {
   case 0: // Temperature & Humidity
-    lcd.print(F("T:"));
-    lcd.print(data.temperature, 1);
-    lcd.print(F("C H:"));
-    lcd.print(data.humidity, 0);
-    lcd.print(F("%"));
-    lcd.setCursor(0, 1);
-    lcd.print(F("Gas:"));
-    lcd.print(data.gasLevel);
+    screen.print(F("T:"));
+    printTenths(screen, data.temperature);
+    screen.print(F("C H:"));
+    printTenths(screen, data.humidity, false);
+    screen.print(F("%"));
+    screen.setCursor(0, 1);
+    screen.print(F("Gas:"));
+    screen.print(data.gasLevel);
     break;
 
   case 1: // Gas & Distance
-    lcd.print(F("Gas:"));
-    lcd.print(data.gasLevel);
-    lcd.print(F(" ("));
-    lcd.print((data.gasLevel * 100) / 1023);
-    lcd.print(F("%)"));
-    lcd.setCursor(0, 1);
-    lcd.print(F("Dist:"));
-    lcd.print(data.distance);
-    lcd.print(F(" cm"));
+    screen.print(F("Gas:"));
+    screen.print(data.gasLevel);
+    screen.print(F(" ("));
+    screen.print(scaleQ16(data.gasLevel, q16Scale(100.0 / 1023)));
+    screen.print(F("%)"));
+    screen.setCursor(0, 1);
+    screen.print(F("Dist:"));
+    screen.print(data.distance);
+    screen.print(F(" cm"));
     break;
 
   case 2: // Pitch & Roll
-    lcd.print(F("Pitch:"));
-    lcd.print(data.pitch, 1);
-    lcd.setCursor(0, 1);
-    lcd.print(F("Roll:"));
-    lcd.print(data.roll, 1);
+    screen.print(F("Pitch:"));
+    printTenths(screen, data.pitch);
+    screen.setCursor(0, 1);
+    screen.print(F("Roll:"));
+    printTenths(screen, data.roll);
     break;
 
   case 3: // Yaw
-    lcd.print(F("Yaw:"));
-    lcd.print(data.yaw, 1);
-    lcd.setCursor(0, 1);
-    lcd.print(F("Heading"));
+    screen.print(F("Yaw:"));
+    printTenths(screen, data.yaw);
+    screen.setCursor(0, 1);
+    screen.print(F("Heading"));
     break;
   }
 }
 
 void displayAlert() {
-  lcd.backlight();
-  lcd.clear();
-  lcd.print(F("!!! ALERT !!!"));
-  lcd.setCursor(0, 1);
-  lcd.print(F("GAS DETECTED!"));
+  screen.backlight();
+  screen.clear();
+  screen.print(F("!!! ALERT !!!"));
+  screen.setCursor(0, 1);
+  screen.print(F("GAS DETECTED!"));
 }
 
 void displayError() {
-  lcd.backlight();
-  lcd.clear();
-  lcd.print(F("SENSOR ERROR"));
-  lcd.setCursor(0, 1);
-  lcd.print(F("Check wiring"));
+  screen.backlight();
+  screen.clear();
+  screen.print(F("SENSOR ERROR"));
+  screen.setCursor(0, 1);
+  screen.print(F("Check wiring"));
 }
 
 // ==========================================
 // RGB LED FUNCTIONS
 // ====================================================================================
 
+// Palette used by the rgbX() helpers and by pattern steps
+enum RGBColorId {
+  COLOR_OFF,
+  COLOR_GREEN,     // Normal operation
+  COLOR_BLUE,      // Uploading data
+  COLOR_RED,       // Hazard alert
+  COLOR_YELLOW,    // Warning/Gas
+  COLOR_PURPLE,    // Idle/ready
+  COLOR_ORANGE,    // Fire alert (≥30°C)
+  COLOR_CYAN,      // Cold/blizzard alert (≤20°C)
+  COLOR_DEEP_BLUE, // Hurricane alert (99-120% humidity)
+  COLOR_COUNT,
+  COLOR_KEEP = 0xFF // Pattern step: leave the LED alone
+};
+
+const uint8_t rgbPalette[COLOR_COUNT][3] PROGMEM = {
+    {0, 0, 0},     {0, 255, 0},   {0, 0, 255},   {255, 0, 0},  {255, 255, 0},
+    {128, 0, 128}, {255, 165, 0}, {0, 255, 255}, {0, 0, 139},
+};
+
+// Last status color set by rgbX(); patterns fall back to it when they end
+volatile uint8_t statusColor = COLOR_OFF;
+
 void setRGBColor(int red, int green, int blue) {
   analogWrite(RGB_RED, red);
   analogWrite(RGB_GREEN, green);
   analogWrite(RGB_BLUE, blue);
 }
 
+// Safe to call from the pattern ISR
+void applyRGBColor(uint8_t color) {
+  setRGBColor(pgm_read_byte(&rgbPalette[color][0]),
+              pgm_read_byte(&rgbPalette[color][1]),
+              pgm_read_byte(&rgbPalette[color][2]));
+}
+
+void setStatusColor(uint8_t color) {
+  noInterrupts(); // The pattern ISR also drives the LED pins
+  statusColor = color;
+  applyRGBColor(color);
+  interrupts();
+}
+
 void initializeRGB() {
   pinMode(RGB_RED, OUTPUT);
   pinMode(RGB_GREEN, OUTPUT);
   pinMode(RGB_BLUE, OUTPUT);
-  setRGBColor(0, 0, 0); // Start with LED off
+  setStatusColor(COLOR_OFF); // Start with LED off
 }
 
 // Status colors
-void rgbOff() { setRGBColor(0, 0, 0); }
+void rgbOff() { setStatusColor(COLOR_OFF); }
 
 void rgbGreen() { // Normal operation
-  setRGBColor(0, 255, 0);
+  setStatusColor(COLOR_GREEN);
 }
 
 void rgbBlue() { // Uploading data
-  setRGBColor(0, 0, 255);
+  setStatusColor(COLOR_BLUE);
 }
 
 void rgbRed() { // Hazard alert
-  setRGBColor(255, 0, 0);
+  setStatusColor(COLOR_RED);
 }
 
 void rgbYellow() { // Warning/Gas
-  setRGBColor(255, 255, 0);
+  setStatusColor(COLOR_YELLOW);
 }
 
 void rgbPurple() { // Idle/ready
-  setRGBColor(128, 0, 128);
+  setStatusColor(COLOR_PURPLE);
 }
 
 // Environmental alert colors
 void rgbOrange() { // Fire alert (≥30°C)
-  setRGBColor(255, 165, 0);
+  setStatusColor(COLOR_ORANGE);
 }
 
 void rgbCyan() { // Cold/blizzard alert (≤20°C)
-  setRGBColor(0, 255, 255);
+  setStatusColor(COLOR_CYAN);
 }
 
 void rgbDeepBlue() { // Hurricane alert (99-120% humidity)
-  setRGBColor(0, 0, 139);
+  setStatusColor(COLOR_DEEP_BLUE);
 }
 
 // ==========================================
 // PIEZO BUZZER FUNCTIONS
 // ==========================================
+// The buzzer is driven by Timer1 in CTC mode toggling OC1A (D9) in
+// hardware, so a tone costs no CPU time at all. Timer1 is otherwise
+// unused (IRremote owns Timer2 and tone() would fight it for it).
+
+#if defined(__AVR__) && BUZZER_PIN != 9
+#error "BUZZER_PIN must be D9 (OC1A) for the Timer1 tone generator"
+#endif
+
+#define BUZZER_PRESCALER 8
+// Compare value for a tone frequency, resolved at compile time
+#define TONE_OCR(hz) ((uint16_t)(F_CPU / (2UL * BUZZER_PRESCALER * (hz)) - 1))
+
+void initializeBuzzer() {
+  pinMode(BUZZER_PIN, OUTPUT);
+  digitalWrite(BUZZER_PIN, LOW);
+#if defined(__AVR__)
+  TCCR1A = 0;
+  TCCR1B = 0;
+#endif
+}
 
-void initializeBuzzer() { pinMode(BUZZER_PIN, OUTPUT); }
+// Start (ocr != 0) or stop (ocr == 0) the square wave. ISR safe.
+void buzzerOutput(uint16_t ocr) {
+#if defined(__AVR__)
+  if (ocr == 0) {
+    TCCR1B = 0;              // Stop the timer
+    TCCR1A = 0;              // Disconnect OC1A from the pin
+    PORTB &= ~_BV(PORTB1);   // Leave D9 low
+  } else {
+    OCR1A = ocr;
+    TCNT1 = 0;
+    TCCR1A = _BV(COM1A0);              // Toggle OC1A on compare match
+    TCCR1B = _BV(WGM12) | _BV(CS11);   // CTC, clk/8
+  }
+#else
+  if (ocr == 0) {
+    noTone(BUZZER_PIN);
+  } else {
+    tone(BUZZER_PIN, F_CPU / (2UL * BUZZER_PRESCALER * (ocr + 1UL)));
+  }
+#endif
+}
+
+// ==========================================
+// BUZZER / RGB PATTERN ENGINE
+// ==========================================
+// Each pattern is a PROGMEM table of steps played back from the
+// Timer0 compare-B interrupt (which fires once per millis() tick,
+// every 1.024 ms). playPattern() returns immediately; a pattern of
+// equal or higher priority replaces the running one, a lower one is
+// dropped. When a pattern ends the LED returns to the status color.
+
+struct PatternStep {
+  uint16_t toneOcr;   // TONE_OCR(hz), 0 = silent
+  uint8_t duration;   // In 10 ms units, 0 = end of pattern
+  uint8_t color;      // RGBColorId or COLOR_KEEP
+};
+
+#define STEP_TONE(hz, ms, color) {TONE_OCR(hz), (ms) / 10, color}
+#define STEP_REST(ms, color) {0, (ms) / 10, color}
+#define STEP_END {0, 0, COLOR_KEEP}
+
+// Short beep - for ready, IR press and state change
+const PatternStep patternBeep[] PROGMEM = {
+    STEP_TONE(TONE_READY, BEEP_SHORT, COLOR_KEEP),
+    STEP_REST(50, COLOR_KEEP),
+    STEP_END,
+};
+
+// Blue flash while data is being sent
+const PatternStep patternUplink[] PROGMEM = {
+    STEP_REST(BEEP_MEDIUM, COLOR_BLUE),
+    STEP_END,
+};
+
+// Environmental hazard - medium length beeps (Beeep Beeep Beeep)
+#define ENVIRONMENTAL_STEPS(color)                                             \
+  STEP_TONE(TONE_HAZARD, 300, color), STEP_REST(300, COLOR_OFF),               \
+      STEP_TONE(TONE_HAZARD, 300, color), STEP_REST(300, COLOR_OFF),           \
+      STEP_TONE(TONE_HAZARD, 300, color), STEP_REST(300, COLOR_OFF), STEP_END
 
-// Short beep - for ready and IR press
-void beepShort() {
-  tone(BUZZER_PIN, TONE_READY, 100);
-  delay(150);
-  noTone(BUZZER_PIN);
+// Obstacle/Tilt - short bursts (5 quick beeps)
+#define BURST_STEPS(color)                                                     \
+  STEP_TONE(TONE_HAZARD, 80, color), STEP_REST(70, COLOR_OFF),                 \
+      STEP_TONE(TONE_HAZARD, 80, color), STEP_REST(70, COLOR_OFF),             \
+      STEP_TONE(TONE_HAZARD, 80, color), STEP_REST(70, COLOR_OFF),             \
+      STEP_TONE(TONE_HAZARD, 80, color), STEP_REST(70, COLOR_OFF),             \
+      STEP_TONE(TONE_HAZARD, 80, color), STEP_REST(70, COLOR_OFF), STEP_END
+
+const PatternStep patternFire[] PROGMEM = {ENVIRONMENTAL_STEPS(COLOR_ORANGE)};
+const PatternStep patternBlizzard[] PROGMEM = {ENVIRONMENTAL_STEPS(COLOR_CYAN)};
+const PatternStep patternHurricane[] PROGMEM = {
+    ENVIRONMENTAL_STEPS(COLOR_DEEP_BLUE)};
+const PatternStep patternGas[] PROGMEM = {ENVIRONMENTAL_STEPS(COLOR_YELLOW)};
+const PatternStep patternHazard[] PROGMEM = {ENVIRONMENTAL_STEPS(COLOR_KEEP)};
+const PatternStep patternObstacle[] PROGMEM = {BURST_STEPS(COLOR_RED)};
+const PatternStep patternTilt[] PROGMEM = {BURST_STEPS(COLOR_RED)};
+
+enum PatternId {
+  PATTERN_BEEP,
+  PATTERN_UPLINK,
+  PATTERN_FIRE,
+  PATTERN_BLIZZARD,
+  PATTERN_HURRICANE,
+  PATTERN_GAS,
+  PATTERN_HAZARD,
+  PATTERN_OBSTACLE,
+  PATTERN_TILT,
+  PATTERN_COUNT
+};
+
+struct PatternInfo {
+  const PatternStep *steps;
+  uint8_t priority; // Higher wins; follows the alert chain order
+};
+
+const PatternInfo patternTable[PATTERN_COUNT] PROGMEM = {
+    {patternBeep, 1},      {patternUplink, 0}, {patternFire, 8},
+    {patternBlizzard, 7},  {patternHurricane, 6}, {patternGas, 5},
+    {patternHazard, 5},    {patternObstacle, 4},  {patternTilt, 3},
+};
+
+// Playback state, shared with the ISR
+const PatternStep *volatile patternStep = NULL; // Current step, NULL = idle
+volatile uint16_t patternMsLeft = 0;
+volatile uint8_t patternPriority = 0;
+
+// Load the step at patternStep (ISR context or interrupts disabled)
+void loadPatternStep() {
+  uint8_t duration = pgm_read_byte(&patternStep->duration);
+
+  if (duration == 0) {
+    buzzerOutput(0);
+    applyRGBColor(statusColor);
+    patternStep = NULL;
+    patternPriority = 0;
+    return;
+  }
+
+  buzzerOutput(pgm_read_word(&patternStep->toneOcr));
+  uint8_t color = pgm_read_byte(&patternStep->color);
+  if (color != COLOR_KEEP) {
+    applyRGBColor(color);
+  }
+  patternMsLeft = duration * 10;
 }
 
-// Ready beep (same as short beep)
-void beepReady() { beepShort(); }
+// One millisecond of playback
+void patternTick() {
+  if (patternStep == NULL || --patternMsLeft > 0) {
+    return;
+  }
+  patternStep++;
+  loadPatternStep();
+}
 
-// IR button press beep
-void beepIR() { beepShort(); }
+void motorTick(); // motor_control.h, runs on the same 1 ms tick
 
-// State change beep (keep for compatibility)
-void beepStateChange() { beepShort(); }
+#if defined(__AVR__)
+ISR(TIMER0_COMPB_vect) {
+  patternTick();
+  motorTick();
+}
+#endif
+
+void initializePatterns() {
+#if defined(__AVR__)
+  // Timer0 keeps running for millis(); borrow its compare-B interrupt
+  // (the motor ramp shares it). OC0B (D5) stays disconnected, so
+  // MOTOR_IN2 is unaffected.
+  OCR0B = 0x80;
+  TIMSK0 |= _BV(OCIE0B);
+#endif
+}
 
-// Obstacle/Tilt - short bursts (5 quick beeps)
-void beepObstacle() {
-  for (int i = 0; i < 5; i++) {
-    tone(BUZZER_PIN, TONE_HAZARD, 80);
-    delay(100);
-    noTone(BUZZER_PIN);
-    delay(50);
+// Start a pattern in the background. Returns false if a higher
+// priority pattern is playing.
+bool playPattern(uint8_t pattern) {
+  uint8_t priority = pgm_read_byte(&patternTable[pattern].priority);
+  bool started = false;
+
+  noInterrupts();
+  if (patternStep == NULL || priority >= patternPriority) {
+    patternStep =
+        (const PatternStep *)pgm_read_ptr(&patternTable[pattern].steps);
+    patternPriority = priority;
+    loadPatternStep();
+    started = true;
   }
+  interrupts();
+
+  return started;
 }
 
-// Environmental hazard - medium length beeps (Beeep Beeep Beeep)
-void beepEnvironmental() {
-  for (int i = 0; i < 3; i++) {
-    tone(BUZZER_PIN, TONE_HAZARD, 300);
-    delay(400);
-    noTone(BUZZER_PIN);
-    delay(200);
+bool isPatternPlaying() { return patternStep != NULL; }
+
+// Without the AVR timer interrupt, step the patterns (and the motor
+// ramp) from the scheduler
+void updatePatterns() {
+#if !defined(__AVR__)
+  static unsigned long lastTick = millis();
+  while (millis() - lastTick >= 1) {
+    lastTick++;
+    patternTick();
+    motorTick();
   }
+#endif
 }
 
+// Ready beep (same as short beep)
+void beepReady() { playPattern(PATTERN_BEEP); }
+
+// IR button press beep
+void beepIR() { playPattern(PATTERN_BEEP); }
+
+// State change beep (keep for compatibility)
+void beepStateChange() { playPattern(PATTERN_BEEP); }
+
 // Gas hazard (use environmental pattern)
-void beepHazard() { beepEnvironmental(); }
+void beepHazard() { playPattern(PATTERN_HAZARD); }
 
 #endif // ACTUATORS_H
@@ -0,0 +1,198 @@
+/*
+ * Hazard Rules for Disaster Recon UAV
+ *
+ * The environmental alerts as a PROGMEM table instead of an if/else
+ * chain. Each rule compares one sample field against a threshold
+ * (config.h) with hysteresis, so a reading hovering on the limit
+ * doesn't flap. Rules are edge-triggered:
+ * - The highest priority active rule is shown on the LCD and its
+ *   pattern is played once, when it becomes the top alert
+ * - When the last rule clears, the normal display comes back
+ * - Rules flagged RULE_RAISES_ALERT also put the UAV in STATE_ALERT
+ *   until they clear (stateHazardActive(), motor_control.h)
+ *
+ * Adding a hazard is one more row in hazardRules[].
+ */
+
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include "actuators.h" // For screen and playPattern()
+#include "config.h"
+#include "fixed.h" // For TENTHS() and printTenths()
+#include "profile.h"
+#include "telemetry.h" // For QuantizedSample (rules work in wire units)
+#include <Arduino.h>
+
+// Comparators
+enum RuleCompare {
+  RULE_AT_LEAST,  // value >= threshold
+  RULE_AT_MOST,   // value <= threshold
+  RULE_BETWEEN,   // threshold <= value <= upper
+  RULE_ABS_ABOVE  // |value| > threshold
+};
+
+// Rule flags
+#define RULE_SHOW_VALUE 0x01   // Print the field value after the detail text
+#define RULE_RAISES_ALERT 0x02 // Holding puts the UAV in STATE_ALERT
+
+struct HazardRule {
+  uint8_t field;      // SampleField
+  uint8_t compare;    // RuleCompare
+  int16_t threshold;  // In the field's wire units
+  int16_t upper;      // Upper bound for RULE_BETWEEN
+  int16_t hysteresis; // How far past the threshold the value must go to clear
+  uint8_t priority;   // Higher wins the LCD
+  uint8_t pattern;    // PatternId played on entry
+  uint8_t flags;
+  const char *title;  // PROGMEM, LCD row 0
+  const char *detail; // PROGMEM, LCD row 1
+};
+
+// Natural units to wire units (see SampleField; TENTHS is in fixed.h)
+#define HALF_PERCENT(x) ((x) * 2)
+
+const char fireTitle[] PROGMEM = "FIRE DETECTED!";
+const char blizzardTitle[] PROGMEM = "BLIZZARD!";
+const char hurricaneTitle[] PROGMEM = "HURRICANE!";
+const char gasTitle[] PROGMEM = "GAS DETECTED!";
+const char obstacleTitle[] PROGMEM = "OBSTACLE!";
+const char tiltTitle[] PROGMEM = "TILT ALERT!";
+const char tempDetail[] PROGMEM = "Temp: ";
+const char humidDetail[] PROGMEM = "Humid: ";
+const char gasDetail[] PROGMEM = "Level: ";
+const char obstacleDetail[] PROGMEM = "Pulling up...";
+const char tiltDetail[] PROGMEM = "Leveling...";
+
+const HazardRule hazardRules[] PROGMEM = {
+    {FIELD_TEMPERATURE, RULE_AT_LEAST, TENTHS(FIRE_TEMP), 0,
+     TENTHS(TEMP_HYSTERESIS), 6, PATTERN_FIRE, RULE_SHOW_VALUE, fireTitle,
+     tempDetail},
+    {FIELD_TEMPERATURE, RULE_AT_MOST, TENTHS(BLIZZARD_TEMP), 0,
+     TENTHS(TEMP_HYSTERESIS), 5, PATTERN_BLIZZARD, RULE_SHOW_VALUE,
+     blizzardTitle, tempDetail},
+    {FIELD_HUMIDITY, RULE_BETWEEN, HALF_PERCENT(HURRICANE_HUMIDITY_MIN),
+     HALF_PERCENT(HURRICANE_HUMIDITY_MAX), HALF_PERCENT(HUMIDITY_HYSTERESIS), 4,
+     PATTERN_HURRICANE, RULE_SHOW_VALUE, hurricaneTitle, humidDetail},
+    {FIELD_GAS, RULE_AT_LEAST, MQ2_THRESHOLD, 0, GAS_HYSTERESIS, 3,
+     PATTERN_GAS, RULE_SHOW_VALUE | RULE_RAISES_ALERT, gasTitle, gasDetail},
+    {FIELD_DISTANCE, RULE_BETWEEN, 1, OBSTACLE_DISTANCE - 1,
+     DISTANCE_HYSTERESIS, 2, PATTERN_OBSTACLE, 0, obstacleTitle,
+     obstacleDetail},
+    {FIELD_PITCH, RULE_ABS_ABOVE, TENTHS(TILT_LIMIT), 0,
+     TENTHS(TILT_HYSTERESIS), 1, PATTERN_TILT, 0, tiltTitle, tiltDetail},
+    {FIELD_ROLL, RULE_ABS_ABOVE, TENTHS(TILT_LIMIT), 0,
+     TENTHS(TILT_HYSTERESIS), 1, PATTERN_TILT, 0, tiltTitle, tiltDetail},
+};
+
+#define HAZARD_RULE_COUNT (sizeof(hazardRules) / sizeof(hazardRules[0]))
+#define HAZARD_NONE 0xFF
+
+static_assert(HAZARD_RULE_COUNT <= 16, "hazardActive has one bit per rule");
+
+uint16_t hazardActive = 0;         // Bit per rule currently holding
+uint8_t hazardShown = HAZARD_NONE; // Rule on the LCD
+uint16_t hazardAlertRules = 0;     // Bit per rule flagged RULE_RAISES_ALERT
+
+// Does the rule hold? margin widens the range once the rule is active
+bool ruleHolds(const HazardRule &rule, int16_t value, int16_t margin) {
+  switch (rule.compare) {
+  case RULE_AT_LEAST:
+    return value >= rule.threshold - margin;
+  case RULE_AT_MOST:
+    return value <= rule.threshold + margin;
+  case RULE_BETWEEN:
+    return value >= rule.threshold - margin && value <= rule.upper + margin;
+  case RULE_ABS_ABOVE:
+    return abs(value) > rule.threshold - margin;
+  }
+  return false;
+}
+
+// Field value in the units shown on the LCD
+void printFieldValue(uint8_t field, int16_t value) {
+  switch (field) {
+  case FIELD_TEMPERATURE:
+    printTenths(screen, value);
+    screen.print(F("C"));
+    break;
+  case FIELD_HUMIDITY:
+    screen.print(value / 2);
+    screen.print(F("%"));
+    break;
+  default:
+    screen.print(value);
+    break;
+  }
+}
+
+void showHazard(const HazardRule &rule, int16_t value) {
+  screen.clear();
+  screen.print((const __FlashStringHelper *)rule.title);
+  screen.setCursor(0, 1);
+  screen.print((const __FlashStringHelper *)rule.detail);
+  if (rule.flags & RULE_SHOW_VALUE) {
+    printFieldValue(rule.field, value);
+  }
+  playPattern(rule.pattern);
+}
+
+// Forget all hazards (UAV switched off)
+void resetHazards() {
+  hazardActive = 0;
+  hazardShown = HAZARD_NONE;
+}
+
+bool hazardOnScreen() { return hazardShown != HAZARD_NONE; }
+
+// Should the UAV be in STATE_ALERT? (as of the last evaluateHazards())
+bool stateHazardActive() { return hazardActive & hazardAlertRules; }
+
+// One pass over the table. Returns true if the last hazard just cleared
+// (the caller should redraw the normal display).
+bool evaluateHazards(const QuantizedSample &sample) {
+  PROFILE_SCOPE(PROF_ALERTS);
+  uint8_t top = HAZARD_NONE;
+  uint8_t topPriority = 0;
+  HazardRule topRule;
+
+  for (uint8_t i = 0; i < HAZARD_RULE_COUNT; i++) {
+    HazardRule rule;
+    memcpy_P(&rule, &hazardRules[i], sizeof(rule));
+
+    uint16_t bit = 1 << i;
+    if (rule.flags & RULE_RAISES_ALERT) {
+      hazardAlertRules |= bit;
+    }
+    int16_t value = sample.field[rule.field];
+    if (value != SAMPLE_INVALID) {
+      // A failed read keeps the previous state
+      bool active = hazardActive & bit;
+      if (ruleHolds(rule, value, active ? rule.hysteresis : 0)) {
+        hazardActive |= bit;
+      } else {
+        hazardActive &= ~bit;
+      }
+    }
+
+    if ((hazardActive & bit) &&
+        (top == HAZARD_NONE || rule.priority > topPriority)) {
+      top = i;
+      topPriority = rule.priority;
+      topRule = rule;
+    }
+  }
+
+  if (top == hazardShown) {
+    return false; // Nothing changed, no side effects
+  }
+
+  bool cleared = top == HAZARD_NONE;
+  hazardShown = top;
+  if (!cleared) {
+    showHazard(topRule, sample.field[topRule.field]);
+  }
+  return cleared;
+}
+
+#endif // ALERTS_H
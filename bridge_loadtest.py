@@ -0,0 +1,529 @@
+#!/usr/bin/env python3
+"""
+===================================================
+Bridge Load Test - Disaster Recon UAV
+===================================================
+
+Runs thingspeak_bidirectional.py against a fake Arduino and a fake
+ThingSpeak, and measures what it does under load:
+
+    feeder --> pty pair --> bridge (child process) --> mock ThingSpeak
+       ^                        |
+       +---- downlink lines ----+
+
+1. The feeder plays a synthetic stream, or a recorded trace, into the
+   master side of a pty as CSV lines or binary telemetry frames, at a
+   given sample rate and paced to the line's baud rate
+2. The bridge runs unmodified in its own process on the pty's slave
+   side; only its settings are overridden (port, URL, spool, rates)
+3. The mock ThingSpeak answers bulk writes and feed reads after an
+   injected delay, and fails a share of them on request
+
+Every sample carries its sequence number in the yaw field (tenths, so
+it survives both formats), which is how arrivals are matched to sends.
+
+Reported: delivered / lost / duplicated samples, latency percentiles
+(serial -> bridge, bridge -> cloud, end to end) and the bridge's CPU
+time per sample. Linux/macOS only (pty).
+
+Usage:
+    python3 bridge_loadtest.py --rate 50 --duration 60 --write-rate 1
+    python3 bridge_loadtest.py --trace sim/traces/sortie.csv --binary \\
+        --latency 0.5 --error-rate 0.1 --lost-reply-rate 0.05
+===================================================
+"""
+
+import argparse
+import json
+import math
+import os
+import random
+import re
+import resource
+import signal
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import tty
+from datetime import datetime
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+from telemetry_protocol import (
+    FRAME_HEADER_SIZE,
+    FRAME_SYNC,
+    FRAME_TELEMETRY,
+    FRAME_VERSION,
+    TELEMETRY_STRUCT,
+    crc16
+)
+
+# ===================================================
+# CONFIGURATION
+# ===================================================
+
+MOCK_CHANNEL_ID = '1'
+SEQ_MODULO = 32768  # Sequence numbers ride in yaw as int16 tenths
+HANDSHAKE_TIMEOUT = 15  # seconds for the bridge to start and answer CONNECT_CLOUD
+STOP_TIMEOUT = 30  # seconds for the bridge to shut down after SIGINT
+BRIDGE_BOOT_BAUD = 9600  # Rate the bridge opens the port at (its BAUD_RATE)
+
+# ===================================================
+# SAMPLE SOURCES
+# ===================================================
+
+def synthetic_samples():
+    """Endless plausible samples: (temp, humid, gas, dist, state, pitch, roll)"""
+    rng = random.Random(1)
+    step = 0
+    while True:
+        t = step * 2.0
+        yield (23 + 0.5 * math.sin(t / 40) + rng.uniform(-0.2, 0.2),
+               48 + 3 * math.sin(t / 70) + rng.uniform(-0.5, 0.5),
+               130 + rng.randint(-10, 10),
+               120 + int(40 * math.sin(t / 25)),
+               2,
+               rng.uniform(-3, 3),
+               rng.uniform(-3, 3))
+        step += 1
+
+def trace_samples(path):
+    """Loop over a recorded trace: the sketch's CSV, optionally as a
+    sim/ trace with a leading ms column. Yaw is replaced by the tag."""
+    rows = []
+    with open(path) as trace:
+        for line in trace:
+            line = line.strip()
+            if not line or not (line[0].isdigit() or line[0] == '-'):
+                continue  # Header or comment
+            values = line.split(',')
+            if len(values) == 9:
+                values = values[1:]
+            if len(values) != 8:
+                raise ValueError(f"{path}: expected 8 or 9 fields: {line}")
+            rows.append((float(values[0]), float(values[1]), int(values[2]),
+                         int(values[3]), int(values[4]), float(values[5]),
+                         float(values[6])))
+    if not rows:
+        raise ValueError(f"{path}: no samples")
+    while True:
+        yield from rows
+
+def encode_csv(sample, seq):
+    temp, humid, gas, dist, state, pitch, roll = sample
+    yaw = (seq % SEQ_MODULO) / 10
+    return (f"{temp:.1f},{humid:.1f},{gas},{dist},{state},"
+            f"{pitch:.1f},{roll:.1f},{yaw:.1f}\r\n").encode('ascii')
+
+def encode_frame(sample, seq):
+    """Telemetry frame as telemetry.h builds it"""
+    temp, humid, gas, dist, state, pitch, roll = sample
+    payload = TELEMETRY_STRUCT.pack(
+        round(temp * 10), round(humid * 2), (gas & 0x03FF) | (state << 12),
+        dist, round(pitch * 10), round(roll * 10), seq % SEQ_MODULO)
+    body = bytes([(FRAME_VERSION << 4) | FRAME_TELEMETRY, seq & 0xFF, len(payload)]) + payload
+    return bytes([FRAME_SYNC]) + body + struct.pack('<H', crc16(body))
+
+def tag_of(yaw):
+    """Sequence number (mod SEQ_MODULO) from an uploaded yaw value"""
+    return round(float(yaw) * 10) % SEQ_MODULO
+
+# ===================================================
+# MOCK THINGSPEAK
+# ===================================================
+
+class MockThingSpeak(ThreadingHTTPServer):
+    """bulk_update.json and feeds.json with injected latency and faults"""
+
+    daemon_threads = True
+
+    def __init__(self, latency, jitter, error_rate, lost_reply_rate):
+        super().__init__(('127.0.0.1', 0), MockHandler)
+        self.latency = latency
+        self.jitter = jitter
+        self.error_rate = error_rate
+        self.lost_reply_rate = lost_reply_rate
+        self.rng = random.Random(2)
+        self.lock = threading.Lock()
+        self.arrivals = []  # (time received, created_at, yaw)
+        self.last_entry = None
+        self.writes = 0
+        self.errors = 0
+        self.lost_replies = 0
+        self.reads = 0
+
+    @property
+    def url(self):
+        return f"http://127.0.0.1:{self.server_address[1]}"
+
+    def delay(self):
+        time.sleep(max(0.0, self.latency + self.rng.uniform(-self.jitter, self.jitter)))
+
+    def fault(self):
+        """None, 'error' (nothing stored) or 'lost' (stored, no reply)"""
+        with self.lock:
+            roll = self.rng.random()
+        if roll < self.error_rate:
+            return 'error'
+        if roll < self.error_rate + self.lost_reply_rate:
+            return 'lost'
+        return None
+
+    def store(self, updates):
+        now = time.time()
+        with self.lock:
+            self.writes += 1
+            for entry in updates:
+                created = datetime.fromisoformat(entry['created_at']).timestamp()
+                self.arrivals.append((now, created, entry['field8']))
+            if updates:
+                self.last_entry = updates[-1]
+
+class MockHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'  # Keep-alive, like the real API
+
+    def log_message(self, format, *args):
+        pass
+
+    def reply(self, status, body):
+        data = json.dumps(body).encode('utf-8')
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def do_POST(self):
+        server = self.server
+        length = int(self.headers.get('Content-Length', 0))
+        body = json.loads(self.rfile.read(length) or b'{}')
+        server.delay()
+
+        if not re.fullmatch(r'/channels/\w+/bulk_update\.json', self.path):
+            self.reply(404, {'error': 'not found'})
+            return
+
+        fault = server.fault()
+        if fault == 'error':
+            with server.lock:
+                server.errors += 1
+            self.reply(500, {'error': 'injected failure'})
+            return
+
+        server.store(body.get('updates', []))
+        if fault == 'lost':
+            # Written, but the client never hears back: it has to retry
+            with server.lock:
+                server.lost_replies += 1
+            self.close_connection = True
+            self.connection.shutdown(2)
+            return
+        self.reply(202, {'success': True})
+
+    def do_GET(self):
+        server = self.server
+        server.delay()
+        if not re.match(r'/channels/\w+/feeds\.json', self.path):
+            self.reply(404, {'error': 'not found'})
+            return
+        with server.lock:
+            server.reads += 1
+            entry = server.last_entry
+        self.reply(200, {'feeds': [entry] if entry else []})
+
+# ===================================================
+# FAKE ARDUINO (MASTER SIDE OF THE PTY)
+# ===================================================
+
+class FakeArduino:
+    """Writes the sample stream and answers the link handshake"""
+
+    def __init__(self, fd, baud):
+        self.fd = fd
+        self.baud = baud
+        self.write_lock = threading.Lock()
+        self.connected = threading.Event()
+        self.downlink_lines = 0
+        self.stop = threading.Event()
+
+    def write(self, data):
+        with self.write_lock:
+            view = memoryview(data)
+            while view:
+                written = os.write(self.fd, view)
+                view = view[written:]
+
+    def line_time(self, size):
+        """Seconds the bytes take on a real UART (10 bits per byte)"""
+        return size * 10 / self.baud
+
+    def read_loop(self):
+        """Drain what the bridge sends so its writes never block"""
+        buffer = b''
+        while not self.stop.is_set():
+            try:
+                chunk = os.read(self.fd, 4096)
+            except OSError:
+                break  # Slave closed
+            if not chunk:
+                break
+            buffer += chunk
+            *lines, buffer = buffer.split(b'\n')
+            for raw in lines:
+                self.handle_line(raw.strip().decode('ascii', 'replace'))
+
+    def handle_line(self, line):
+        if line.startswith('CLOUD_OK'):
+            rate = line.partition(':')[2]
+            if rate.isdigit() and int(rate) != BRIDGE_BOOT_BAUD:
+                self.write(b"BAUD_CHECK\r\n")  # Same as the sketch at the new rate
+            else:
+                self.connected.set()
+        elif line == 'BAUD_OK':
+            self.connected.set()
+        elif '|' in line:
+            self.downlink_lines += 1
+
+    def handshake(self):
+        """CONNECT_CLOUD until the bridge is up and agrees on the rate"""
+        deadline = time.monotonic() + HANDSHAKE_TIMEOUT
+        while time.monotonic() < deadline:
+            self.write(f"CONNECT_CLOUD:{self.baud}\r\n".encode('ascii'))
+            if self.connected.wait(1):
+                return True
+        return False
+
+# ===================================================
+# BRIDGE CHILD PROCESS
+# ===================================================
+
+def run_bridge_child(settings):
+    """Entry point of the child: override settings, run the bridge as is"""
+    import thingspeak_bidirectional as bridge
+    for name, value in settings.items():
+        setattr(bridge, name, value)
+    bridge.main()
+
+def start_bridge(port, mock_url, spool_path, args):
+    settings = {
+        'COM_PORT': port,
+        'THINGSPEAK_URL': mock_url,
+        'CHANNEL_ID': MOCK_CHANNEL_ID,
+        'SPOOL_PATH': spool_path,
+        'WRITE_RATE': args.write_rate,
+        'BULK_MAX_SAMPLES': args.bulk_max,
+        'MAX_BAUD_RATE': max(args.baud, BRIDGE_BOOT_BAUD),
+        'HTTP_TIMEOUT': args.http_timeout,
+        'MAX_BACKOFF': args.max_backoff,
+        'STATS_INTERVAL': 0,
+        'DASHBOARD_PORT': args.dashboard_port,
+    }
+    here = os.path.dirname(os.path.abspath(__file__))
+    return subprocess.Popen(
+        [sys.executable, os.path.abspath(__file__), '--bridge-child', json.dumps(settings)],
+        cwd=here,
+        stdout=None if args.verbose else subprocess.DEVNULL)
+
+# ===================================================
+# LOAD TEST
+# ===================================================
+
+def feed(arduino, samples, args, sent_times):
+    """Send samples at args.rate for args.duration; returns the count sent"""
+    encode = encode_frame if args.binary else encode_csv
+    rng = random.Random(3)
+    interval = 1 / args.rate
+    start = time.monotonic()
+    seq = 0
+
+    while time.monotonic() - start < args.duration:
+        data = bytearray(encode(next(samples), seq))
+        if args.corrupt_rate and rng.random() < args.corrupt_rate:
+            data[rng.randrange(FRAME_HEADER_SIZE, len(data) - 2)] ^= 0x10
+        sent_times[seq % SEQ_MODULO] = time.time()
+        arduino.write(bytes(data))
+        seq += 1
+
+        # The UART can't go faster than the baud rate, whatever the rate asks
+        next_send = start + seq * interval
+        busy_until = time.monotonic() + arduino.line_time(len(data))
+        delay = max(next_send, busy_until) - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+    return seq, time.monotonic() - start
+
+def percentiles(values):
+    if not values:
+        return "n/a"
+    values = sorted(values)
+    def pick(q):
+        return values[min(len(values) - 1, int(q * len(values)))]
+    return (f"p50 {pick(0.50) * 1000:8.1f} ms  p90 {pick(0.90) * 1000:8.1f} ms  "
+            f"p99 {pick(0.99) * 1000:8.1f} ms  max {values[-1] * 1000:8.1f} ms")
+
+def process_cpu_seconds(pid):
+    """CPU time a running process has used (Linux /proc), None elsewhere"""
+    try:
+        with open(f'/proc/{pid}/stat') as stat:
+            fields = stat.read().rsplit(')', 1)[1].split()
+        return (int(fields[11]) + int(fields[12])) / os.sysconf('SC_CLK_TCK')
+    except (OSError, ValueError, IndexError):
+        return None
+
+def run(args):
+    samples = trace_samples(args.trace) if args.trace else synthetic_samples()
+
+    master, slave = os.openpty()
+    tty.setraw(slave)  # No echo or line editing before the bridge opens it
+    port = os.ttyname(slave)
+
+    mock = MockThingSpeak(args.latency, args.jitter, args.error_rate, args.lost_reply_rate)
+    threading.Thread(target=mock.serve_forever, name="mock-thingspeak", daemon=True).start()
+
+    arduino = FakeArduino(master, args.baud)
+    threading.Thread(target=arduino.read_loop, name="fake-arduino", daemon=True).start()
+
+    spool_dir = tempfile.mkdtemp(prefix='uav_loadtest_')
+    cpu_before = resource.getrusage(resource.RUSAGE_CHILDREN)
+    child = start_bridge(port, mock.url, os.path.join(spool_dir, 'spool.db'), args)
+
+    sent_times = {}
+    cpu_window = None
+    try:
+        if not arduino.handshake():
+            print("✗ Bridge never answered CONNECT_CLOUD", file=sys.stderr)
+            return 1
+
+        print(f"Feeding {args.rate:g} samples/s for {args.duration:g} s "
+              f"({'binary' if args.binary else 'CSV'}, {args.baud} baud)...")
+        cpu_start = process_cpu_seconds(child.pid)
+        sent, feed_seconds = feed(arduino, samples, args, sent_times)
+
+        # Let the spool drain: stop once nothing new has arrived for a while
+        drain_deadline = time.monotonic() + args.drain
+        while time.monotonic() < drain_deadline:
+            with mock.lock:
+                delivered = len({tag_of(yaw) for _, _, yaw in mock.arrivals})
+            if delivered >= sent:
+                break
+            time.sleep(0.2)
+
+        cpu_end = process_cpu_seconds(child.pid)
+        if cpu_start is not None and cpu_end is not None:
+            cpu_window = cpu_end - cpu_start
+    finally:
+        child.send_signal(signal.SIGINT)
+        try:
+            child.wait(STOP_TIMEOUT)
+        except subprocess.TimeoutExpired:
+            child.kill()
+            child.wait()
+        arduino.stop.set()
+        mock.shutdown()
+        os.close(master)
+        os.close(slave)
+
+    cpu_after = resource.getrusage(resource.RUSAGE_CHILDREN)
+    cpu_total = (cpu_after.ru_utime - cpu_before.ru_utime) + (cpu_after.ru_stime - cpu_before.ru_stime)
+    # Without /proc, fall back to the whole run including start-up
+    cpu = cpu_window if cpu_window is not None else cpu_total
+    report(args, mock, arduino, sent, feed_seconds, sent_times, cpu, cpu_total)
+    return 0
+
+def report(args, mock, arduino, sent, feed_seconds, sent_times, cpu, cpu_total):
+    ingest, upload, total = [], [], []
+    seen = set()
+    duplicates = 0
+    for received, created, yaw in mock.arrivals:
+        tag = tag_of(yaw)
+        if tag in seen:
+            duplicates += 1
+            continue
+        seen.add(tag)
+        sent_at = sent_times.get(tag)
+        if sent_at is None:
+            continue
+        ingest.append(created - sent_at)
+        upload.append(received - created)
+        total.append(received - sent_at)
+
+    delivered = len(seen)
+    lost = sent - delivered
+    results = {
+        'sent': sent,
+        'offered_rate': args.rate,
+        'achieved_rate': sent / feed_seconds if feed_seconds else 0,
+        'delivered': delivered,
+        'lost': lost,
+        'duplicates': duplicates,
+        'writes': mock.writes,
+        'injected_errors': mock.errors,
+        'injected_lost_replies': mock.lost_replies,
+        'reads': mock.reads,
+        'downlink_lines': arduino.downlink_lines,
+        'bridge_cpu_seconds': cpu,
+        'bridge_cpu_seconds_total': cpu_total,
+        'cpu_ms_per_sample': cpu * 1000 / sent if sent else 0,
+    }
+
+    print()
+    print("=" * 60)
+    print(" BRIDGE LOAD TEST")
+    print("=" * 60)
+    print(f"Sent:        {sent} samples in {feed_seconds:.1f} s "
+          f"({results['achieved_rate']:.1f}/s of {args.rate:g}/s offered)")
+    print(f"Delivered:   {delivered} ({delivered * 100 / sent if sent else 0:.1f}%), "
+          f"lost {lost}, duplicated {duplicates}")
+    print(f"Cloud:       {mock.writes} bulk writes "
+          f"(avg {len(mock.arrivals) / mock.writes if mock.writes else 0:.1f} samples), "
+          f"{mock.errors} injected errors, {mock.lost_replies} lost replies, {mock.reads} reads")
+    print(f"Downlink:    {arduino.downlink_lines} lines back to the Arduino")
+    print(f"Latency serial -> bridge: {percentiles(ingest)}")
+    print(f"Latency bridge -> cloud:  {percentiles(upload)}")
+    print(f"Latency end to end:       {percentiles(total)}")
+    print(f"Bridge CPU:  {results['cpu_ms_per_sample']:.3f} ms per sample, "
+          f"{cpu * 100 / feed_seconds if feed_seconds else 0:.1f}% of a core while feeding "
+          f"({cpu:.2f} s; {cpu_total:.2f} s with start-up)")
+    print("=" * 60)
+
+    if args.json:
+        with open(args.json, 'w') as out:
+            json.dump(results, out, indent=2)
+
+# ===================================================
+# ENTRY POINT
+# ===================================================
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="Replay/load test for thingspeak_bidirectional.py")
+    parser.add_argument('--rate', type=float, default=0.5, help="samples per second (sketch: 0.5)")
+    parser.add_argument('--duration', type=float, default=60, help="seconds of feeding")
+    parser.add_argument('--baud', type=int, default=BRIDGE_BOOT_BAUD, help="link rate negotiated and paced to")
+    parser.add_argument('--binary', action='store_true', help="send telemetry frames instead of CSV")
+    parser.add_argument('--trace', help="replay this CSV trace instead of synthetic data")
+    parser.add_argument('--corrupt-rate', type=float, default=0, help="share of samples with a flipped bit")
+    parser.add_argument('--latency', type=float, default=0.2, help="mock ThingSpeak response delay (s)")
+    parser.add_argument('--jitter', type=float, default=0.1, help="± random part of the delay (s)")
+    parser.add_argument('--error-rate', type=float, default=0, help="share of writes answered 500")
+    parser.add_argument('--lost-reply-rate', type=float, default=0,
+                        help="share of writes stored but never answered")
+    parser.add_argument('--write-rate', type=float, default=1 / 15, help="bridge WRITE_RATE (requests/s)")
+    parser.add_argument('--bulk-max', type=int, default=960, help="bridge BULK_MAX_SAMPLES")
+    parser.add_argument('--http-timeout', type=float, default=10, help="bridge HTTP_TIMEOUT (s)")
+    parser.add_argument('--max-backoff', type=float, default=120, help="bridge MAX_BACKOFF (s)")
+    parser.add_argument('--dashboard-port', type=int, default=0, help="bridge DASHBOARD_PORT (default 0 = off)")
+    parser.add_argument('--drain', type=float, default=60, help="max seconds to wait for the spool to empty")
+    parser.add_argument('--json', help="also write the results here")
+    parser.add_argument('--verbose', action='store_true', help="show the bridge's own output")
+    args = parser.parse_args()
+    if args.rate <= 0 or args.duration <= 0 or args.write_rate <= 0:
+        parser.error("--rate, --duration and --write-rate must be positive")
+    return args
+
+if __name__ == "__main__":
+    if len(sys.argv) == 3 and sys.argv[1] == '--bridge-child':
+        run_bridge_child(json.loads(sys.argv[2]))
+    else:
+        sys.exit(run(parse_args()))
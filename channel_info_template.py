@@ -14,5 +14,12 @@ THINGSPEAK_WRITE_API_KEY = "YOUR_WRITE_API_KEY_HERE"
 THINGSPEAK_READ_API_KEY = "YOUR_READ_API_KEY_HERE"
 THINGSPEAK_CHANNEL_ID = 0000000  # Your channel ID
 
+# Fleet gateway (fleet_gateway.py): one channel per UAV, keyed by the
+# DEVICE_ID in that UAV's config.h
+FLEET_CHANNELS = {
+    1: {"channel_id": 0000000, "write_api_key": "UAV1_WRITE_API_KEY", "read_api_key": "UAV1_READ_API_KEY"},
+    2: {"channel_id": 0000000, "write_api_key": "UAV2_WRITE_API_KEY", "read_api_key": "UAV2_READ_API_KEY"},
+}
+
 # Student Identification
 STUDENT_ID = "000000000"  # Your student ID if you are logging into ThingSpeak through your institution.
@@ -0,0 +1,175 @@
+/*
+ * Cloud Link State Machine for Disaster Recon UAV
+ *
+ * Tracks whether the Python bridge (and ThingSpeak behind it) is
+ * there, without ever waiting on it:
+ *
+ *   DISCONNECTED --> CONNECTING --CLOUD_OK--> CONNECTED <--+
+ *        ^   ^            |                      |         | heard
+ *        |   +------------+ CLOUD_FAIL/timeout   | quiet   | again
+ *        |     (retry after a growing delay)     v         |
+ *        +------------- quiet for too long ---- DEGRADED --+
+ *
+ * - stepCloud() runs from a scheduler task and makes at most one
+ *   transition per call; it returns what the sketch should do about
+ *   it (send CONNECT_CLOUD, send a PING, tell the pilot)
+ * - Every line from the bridge counts as a heartbeat (cloudHeard());
+ *   PING is only sent when the link has gone quiet, and the bridge
+ *   answers it with PONG
+ * - The sketch keeps sending samples in every state: the bridge spools
+ *   them, so a flapping link only delays the read-back
+ *
+ * The timeouts live in config.h (CLOUD_*).
+ */
+
+#ifndef CLOUD_H
+#define CLOUD_H
+
+#include "config.h"
+#include <Arduino.h>
+
+enum CloudState : uint8_t {
+  CLOUD_DISCONNECTED, // Not wanted, or waiting to retry
+  CLOUD_CONNECTING,   // CONNECT_CLOUD sent, waiting for the reply
+  CLOUD_CONNECTED,    // Bridge heard from recently
+  CLOUD_DEGRADED      // Bridge quiet for a while, still pinging
+};
+
+// What the caller should do after an event or step
+enum CloudAction : uint8_t {
+  CLOUD_NONE,
+  CLOUD_SEND_CONNECT, // Send CONNECT_CLOUD
+  CLOUD_SEND_PING,    // Send PING
+  CLOUD_LINK_UP,      // CLOUD_OK accepted, or a degraded link recovered
+  CLOUD_REJECTED,     // CLOUD_FAIL, retry scheduled
+  CLOUD_TIMED_OUT,    // No reply to CONNECT_CLOUD, retry scheduled
+  CLOUD_LINK_QUIET,   // CONNECTED -> DEGRADED
+  CLOUD_LINK_LOST     // DEGRADED -> DISCONNECTED, reconnecting
+};
+
+struct CloudLink {
+  uint8_t state;
+  bool wanted;             // UAV is on and should be connected
+  uint8_t failures;        // Attempts failed since the last connection
+  uint16_t retryDelay;     // ms before the next attempt, doubled per failure
+  unsigned long since;     // millis() of the last state change
+  unsigned long lastHeard; // millis() of the last line from the bridge
+  unsigned long lastPing;  // millis() of the last PING sent
+  unsigned long retryAt;   // millis() of the next attempt (DISCONNECTED)
+};
+
+CloudLink cloud = {CLOUD_DISCONNECTED, false, 0, CLOUD_RETRY_MIN, 0, 0, 0, 0};
+
+void enterCloudState(CloudLink &link, uint8_t state, unsigned long now) {
+  link.state = state;
+  link.since = now;
+}
+
+// Connected or degraded: the last cloud data is still worth showing
+bool cloudLinkUp(const CloudLink &link) {
+  return link.state == CLOUD_CONNECTED || link.state == CLOUD_DEGRADED;
+}
+
+// ==========================================
+// EVENTS
+// ==========================================
+
+// Start connecting on the next step
+void startCloud(CloudLink &link, unsigned long now) {
+  link.wanted = true;
+  link.failures = 0;
+  link.retryDelay = CLOUD_RETRY_MIN;
+  link.retryAt = now;
+  enterCloudState(link, CLOUD_DISCONNECTED, now);
+}
+
+// Give up on the link (UAV switched off)
+void stopCloud(CloudLink &link, unsigned long now) {
+  link.wanted = false;
+  enterCloudState(link, CLOUD_DISCONNECTED, now);
+}
+
+// A complete line came in from the bridge
+uint8_t cloudHeard(CloudLink &link, unsigned long now) {
+  link.lastHeard = now;
+  if (link.state == CLOUD_DEGRADED) {
+    enterCloudState(link, CLOUD_CONNECTED, now);
+    return CLOUD_LINK_UP;
+  }
+  return CLOUD_NONE;
+}
+
+// Failed attempt: wait, longer each time, then try again
+void scheduleCloudRetry(CloudLink &link, unsigned long now) {
+  link.retryAt = now + link.retryDelay;
+  unsigned long next = (unsigned long)link.retryDelay * 2;
+  link.retryDelay = next > CLOUD_RETRY_MAX ? CLOUD_RETRY_MAX : next;
+  if (link.failures < 0xFF) {
+    link.failures++;
+  }
+  enterCloudState(link, CLOUD_DISCONNECTED, now);
+}
+
+// CLOUD_OK (accepted) or CLOUD_FAIL; ignored unless we asked
+uint8_t cloudReply(CloudLink &link, unsigned long now, bool accepted) {
+  if (link.state != CLOUD_CONNECTING) {
+    return CLOUD_NONE;
+  }
+  if (!accepted) {
+    scheduleCloudRetry(link, now);
+    return CLOUD_REJECTED;
+  }
+  link.failures = 0;
+  link.retryDelay = CLOUD_RETRY_MIN;
+  link.lastHeard = now;
+  link.lastPing = now;
+  enterCloudState(link, CLOUD_CONNECTED, now);
+  return CLOUD_LINK_UP;
+}
+
+// ==========================================
+// STEP (one transition at most)
+// ==========================================
+
+uint8_t stepCloud(CloudLink &link, unsigned long now) {
+  if (!link.wanted) {
+    return CLOUD_NONE;
+  }
+
+  switch (link.state) {
+  case CLOUD_DISCONNECTED:
+    if ((long)(now - link.retryAt) >= 0) {
+      enterCloudState(link, CLOUD_CONNECTING, now);
+      return CLOUD_SEND_CONNECT;
+    }
+    return CLOUD_NONE;
+
+  case CLOUD_CONNECTING:
+    if (now - link.since >= CLOUD_CONNECT_TIMEOUT) {
+      scheduleCloudRetry(link, now);
+      return CLOUD_TIMED_OUT;
+    }
+    return CLOUD_NONE;
+
+  default: // CONNECTED or DEGRADED
+    break;
+  }
+
+  unsigned long quiet = now - link.lastHeard;
+  if (link.state == CLOUD_CONNECTED && quiet >= CLOUD_QUIET_TIMEOUT) {
+    enterCloudState(link, CLOUD_DEGRADED, now);
+    return CLOUD_LINK_QUIET;
+  }
+  if (link.state == CLOUD_DEGRADED && quiet >= CLOUD_LOST_TIMEOUT) {
+    link.retryAt = now; // Reconnect right away
+    enterCloudState(link, CLOUD_DISCONNECTED, now);
+    return CLOUD_LINK_LOST;
+  }
+  if (quiet >= CLOUD_PING_INTERVAL && now - link.lastPing >= CLOUD_PING_INTERVAL) {
+    link.lastPing = now;
+    return CLOUD_SEND_PING;
+  }
+  return CLOUD_NONE;
+}
+
+#endif // CLOUD_H
@@ -8,6 +8,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <Arduino.h> // For uint8_t (UAVState)
+
 // ==========================================
 // PIN DEFINITIONS
 // ==========================================
@@ -28,11 +30,13 @@
 // DC Motor Control (L293D)
 #define MOTOR_IN1 4    // L293D IN1 (D4 - direction control)
 #define MOTOR_IN2 5    // L293D IN2 (D5 - direction control)
-#define MOTOR_ENABLE 3 // L293D Enable (D3 PWM - speed control)
+#define MOTOR_ENABLE 3 // L293D Enable (D3 - speed, sigma-delta from the 1 ms tick)
 
 // I2C Devices (use hardware I2C pins)
 #define LCD_ADDRESS 0x27 // LCD I2C address
 #define MPU_ADDRESS 0x68 // MPU6050 I2C address
+#define I2C_CLOCK 400000 // Bus clock (Hz); use 100000 if the LCD backpack garbles
+#define I2C_TIMEOUT_US 5000 // A transfer stuck this long is abandoned (AVR core 1.8.3+)
 
 // ==========================================
 // SENSOR THRESHOLDS
@@ -44,27 +48,107 @@
 // Distance Limits (cm)
 #define MIN_DISTANCE 2   // Minimum valid distance
 #define MAX_DISTANCE 400 // Maximum valid distance
+#define OBSTACLE_DISTANCE 5 // Closer than this = obstacle alert
+#define RANGING_INTERVAL 40 // ms between pings (25 Hz)
+
+// Attitude (MPU6050)
+#define TILT_LIMIT 45      // degrees of pitch/roll before a tilt alert
+#define IMU_RATE_HZ 100    // Sample/fusion rate (divides 1 kHz evenly)
+#define IMU_DRAIN_INTERVAL 20 // ms between FIFO drains (2 samples at 100 Hz)
+#define IMU_RING_SIZE 8        // Raw samples buffered between fusion steps
+#define IMU_FUSION_SHIFT 6 // Accel weight 1/64 per sample (~0.6 s at 100 Hz)
+
+// Hazard rules (alerts.h) - natural units
+#define FIRE_TEMP 30              // °C, at or above = fire
+#define BLIZZARD_TEMP 20          // °C, at or below = blizzard
+#define HURRICANE_HUMIDITY_MIN 99 // %, hurricane band
+#define HURRICANE_HUMIDITY_MAX 120
+#define TEMP_HYSTERESIS 1         // °C past the limit before clearing
+#define HUMIDITY_HYSTERESIS 2     // %
+#define GAS_HYSTERESIS 20         // Analog counts
+#define DISTANCE_HYSTERESIS 2     // cm
+#define TILT_HYSTERESIS 5         // degrees
+
+// Adaptive sampling (rates.h) - ms between reads, per sensor and level:
+// CALM  = every reading clear of its hazard limits
+// NEAR  = a reading within RATE_NEAR_FACTOR x hysteresis of a limit
+// ALERT = one of the sensor's hazards holds, or STATE_ALERT
+//                      CALM  NEAR  ALERT
+#define RATE_GAS        1000, 100,  50                 // MQ-2, drives STATE_ALERT
+#define RATE_RANGING    100,  50,   RANGING_INTERVAL   // HC-SR04 pings
+#define RATE_IMU        60,   40,   IMU_DRAIN_INTERVAL // MPU FIFO drains
+#define RATE_CLIMATE    4000, 2000, 1000               // DHT11 (1 Hz at most)
+#define RATE_NEAR_FACTOR 5      // Near zone, in hysteresis widths past the limit
+#define RATE_UPDATE_INTERVAL 100 // ms between rate level updates
 
 // Temperature Limits (°C) - optional warnings
 #define TEMP_WARNING_HIGH 40
 #define TEMP_WARNING_LOW 0
 
+// ==========================================
+// SENSOR HEALTH (health.h)
+// ==========================================
+
+#define HEALTH_FAULT_STREAK 3 // Failed reads in a row before a sensor counts as down
+#define HEALTH_RETRY_MIN 2000 // ms before a sensor that is down is tried again
+#define HEALTH_RETRY_MAX 60000 // ms, retry delay stops doubling here
+#define WATCHDOG_ENABLED 1    // Reset the board if a scheduler pass hangs (~2 s)
+
+// ==========================================
+// MOTOR SPEEDS (motor_control.h)
+// ==========================================
+
+#define MOTOR_SPEED_IDLE 160   // 0-255, while warming up
+#define MOTOR_SPEED_ACTIVE 255 // ACTIVE and ALERT
+#define MOTOR_RAMP_MS 4        // ms per speed step (0 -> 255 in ~1 s)
+
 // ==========================================
 // DRONE STATE DEFINITIONS
 // ==========================================
 
-#define STATE_OFF 0    // UAV powered off
-#define STATE_IDLE 1   // UAV on, initializing
-#define STATE_ACTIVE 2 // Normal operation, collecting data
-#define STATE_ALERT 3  // Hazard detected (high gas)
-#define STATE_ERROR 4  // Sensor malfunction
+// The values go out as field 5 / the frame state bits: keep them fixed
+enum UAVState : uint8_t {
+  STATE_OFF,    // UAV powered off
+  STATE_IDLE,   // UAV on, initializing
+  STATE_ACTIVE, // Normal operation, collecting data
+  STATE_ALERT,  // Hazard detected (rules flagged RULE_RAISES_ALERT)
+  STATE_ERROR,  // Sensor malfunction
+  STATE_COUNT
+};
 
 // ==========================================
 // COMMUNICATION SETTINGS
 // ==========================================
 
-#define BAUD_RATE 9600        // Serial communication baud rate
-#define UPDATE_INTERVAL 15000 // Data update interval (15 seconds in ms)
+#define DEVICE_ID 1           // Airframe number (1-255), tags every sample for the fleet gateway
+#define BAUD_RATE 9600        // Boot and fallback baud rate
+#define BAUD_RATE_MAX 250000  // Highest rate offered to the bridge (exact at 16 MHz)
+#define BAUD_SWITCH_TIMEOUT 1000 // ms to confirm a new rate before falling back
+#define CLOUD_TICK 100             // ms between cloud link state machine steps
+#define CLOUD_CONNECT_TIMEOUT 5000 // ms to wait for CLOUD_OK / CLOUD_FAIL
+#define CLOUD_RETRY_MIN 2000       // ms before the first reconnect attempt
+#define CLOUD_RETRY_MAX 60000      // ms, retry delay stops doubling here
+#define CLOUD_PING_INTERVAL 5000   // ms of bridge silence before each PING
+#define CLOUD_QUIET_TIMEOUT 15000  // ms of silence before the link is DEGRADED
+#define CLOUD_LOST_TIMEOUT 45000   // ms of silence before reconnecting
+#define CLOUD_DATA_STALE 150000UL  // ms a read-back field stays current (bridge confirms every 60 s)
+#define LOG_LEVEL 3  // 0 none, 1 error, 2 warn, 3 info, 4 debug (see log.h)
+#define LOG_FRAMES 1 // 1 = logs as binary frames, 0 = text for Serial Monitor
+#define PROFILE_ENABLED 1 // Loop/section timing, sent on STATS (see profile.h)
+#define UPDATE_INTERVAL 2000  // Data update interval (2 s; bridge batches them)
+#define LIVE_ENABLED 1        // 1 = fast pitch/roll/yaw/distance for the live dashboard
+#define LIVE_INTERVAL 200     // ms between live updates (shown, not uploaded)
+#define TELEMETRY_BINARY 0    // 1 = send packed binary frames instead of CSV
+#define TELEMETRY_DELTA 0     // 1 = keyframes + small deltas (binary mode only)
+#define TELEMETRY_KEYFRAME_INTERVAL 10 // Samples per full keyframe in delta mode
+#define DEADBAND_TEMPERATURE 2 // Delta mode: changes this small aren't sent
+#define DEADBAND_HUMIDITY 2    //   (wire units: 0.1 °C, 0.5 %, ADC counts,
+#define DEADBAND_GAS 4         //   cm, 0.1 °); every keyframe is exact
+#define DEADBAND_DISTANCE 1
+#define DEADBAND_ATTITUDE 5    // Pitch, roll and yaw
+#define HISTORY_INTERVAL 1000 // ms between samples kept in the history
+#define HISTORY_SIZE 8        // Samples in the on-device history ring
+#define WINDOW_SAMPLES 15     // Samples per window statistics report
 
 // ==========================================
 // IR REMOTE CODES
@@ -73,6 +157,7 @@
 
 #define IR_BUTTON_ON 0x47E9055D  // Button "1" - Turn UAV ON
 #define IR_BUTTON_OFF 0x3BDAB6CD // Button "2" - Turn UAV OFF
+#define IR_QUEUE_SIZE 4          // Presses held until taskIR() runs (power of 2)
 
 // ==========================================
 // BUZZER TONES & DURATIONS
@@ -98,5 +183,7 @@
 
 #define LCD_COLS 16 // LCD columns
 #define LCD_ROWS 2  // LCD rows
+#define LCD_FLUSH_CELLS 4     // Changed cells sent per flush
+#define LCD_FLUSH_INTERVAL 5  // ms between flushes
 
 #endif // CONFIG_H
@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+"""
+===================================================
+Live Dashboard - Disaster Recon UAV
+===================================================
+
+Pushes every sample the bridge decodes to browsers as it arrives, as
+Server-Sent Events, instead of waiting for ThingSpeak to refresh:
+
+    serial reader --publish()--> queue per client --> client thread --> browser
+                                 (bounded, oldest dropped)
+
+- GET /        one-page live view (attitude, distance, gas, climate)
+- GET /events  text/event-stream: a `sample` event per decoded sample,
+               and `skipped` (how many were dropped) when a client
+               fell behind
+
+Besides the full samples (every UPDATE_INTERVAL, 2 s) the sketch sends
+pitch, roll, yaw and distance every LIVE_INTERVAL (200 ms, 5 Hz). The
+bridge publishes those here but never spools or uploads them.
+
+publish() never blocks the serial reader: each sample is turned into
+JSON once and offered to every client's queue. A slow client only
+loses its own oldest samples, so it always catches up to the newest;
+one that stops reading is cut off when a write times out.
+
+Runs inside thingspeak_bidirectional.py and fleet_gateway.py
+(DASHBOARD_PORT there, 0 = off).
+===================================================
+"""
+
+import json
+import threading
+from collections import deque
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+# ===================================================
+# CONFIGURATION
+# ===================================================
+
+CLIENT_QUEUE_DEPTH = 32  # samples a client may fall behind before the oldest are dropped
+MAX_CLIENTS = 16  # browsers at once; more get 503
+KEEPALIVE_INTERVAL = 15  # seconds of no samples before a comment line (detects closed tabs)
+WRITE_TIMEOUT = 5  # seconds a client may take to accept a write
+RETRY_MS = 2000  # browser reconnect delay after the stream ends
+
+# ===================================================
+# FAN-OUT
+# ===================================================
+
+class DashboardClient:
+    """One browser's queue of events not sent yet"""
+
+    def __init__(self, depth):
+        self.events = deque(maxlen=depth)
+        self.ready = threading.Condition()
+        self.skipped = 0  # Dropped since the last send
+        self.closed = False
+
+    def offer(self, event):
+        with self.ready:
+            if len(self.events) == self.events.maxlen:
+                self.skipped += 1  # append() drops the oldest
+            self.events.append(event)
+            self.ready.notify()
+
+    def close(self):
+        with self.ready:
+            self.closed = True
+            self.ready.notify()
+
+    def take(self, timeout):
+        """(events, skipped) waiting now; nothing after timeout or close"""
+        with self.ready:
+            if not self.events and not self.closed:
+                self.ready.wait(timeout)
+            events = list(self.events)
+            self.events.clear()
+            skipped, self.skipped = self.skipped, 0
+            return events, skipped
+
+class Dashboard:
+    """HTTP server on its own threads, fed by publish()"""
+
+    def __init__(self, host, port, depth=CLIENT_QUEUE_DEPTH):
+        self.address = (host, port)
+        self.depth = depth
+        self.clients = set()
+        self.lock = threading.Lock()
+        self.sequence = 0
+        self.server = None
+
+    def start(self):
+        """Listen; returns False (and the bridge carries on) if the port is taken"""
+        try:
+            self.server = ThreadingHTTPServer(self.address, DashboardHandler)
+        except OSError as e:
+            print(f"⚠️  Dashboard not started on port {self.address[1]}: {e}")
+            return False
+        self.server.daemon_threads = True
+        self.server.dashboard = self
+        threading.Thread(target=self.server.serve_forever, name="dashboard", daemon=True).start()
+        host = self.address[0] or '0.0.0.0'
+        print(f"✓ Live dashboard on http://{host}:{self.address[1]}/")
+        return True
+
+    def stop(self):
+        if self.server:
+            self.server.shutdown()
+            self.server.server_close()
+        with self.lock:
+            for client in self.clients:
+                client.close()
+
+    def publish(self, sample_time, data, device=None):
+        """Offer a sample to every client (called from the serial reader)"""
+        with self.lock:
+            if not self.clients:
+                return
+            self.sequence += 1
+            event = dict(data, time=sample_time)
+            if device is not None:
+                event['device'] = device
+            text = f"id: {self.sequence}\nevent: sample\ndata: {json.dumps(event)}\n\n"
+            for client in self.clients:
+                client.offer(text)
+
+    def add_client(self):
+        with self.lock:
+            if len(self.clients) >= MAX_CLIENTS:
+                return None
+            client = DashboardClient(self.depth)
+            self.clients.add(client)
+            return client
+
+    def remove_client(self, client):
+        with self.lock:
+            self.clients.discard(client)
+
+# ===================================================
+# HTTP
+# ===================================================
+
+class DashboardHandler(BaseHTTPRequestHandler):
+    """/ serves the page, /events streams the samples"""
+
+    def do_GET(self):
+        path = self.path.partition('?')[0]
+        if path == '/':
+            body = DASHBOARD_PAGE.encode('utf-8')
+            self.send_response(200)
+            self.send_header('Content-Type', 'text/html; charset=utf-8')
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+        elif path == '/events':
+            self.stream()
+        else:
+            self.send_error(404)
+
+    def stream(self):
+        dashboard = self.server.dashboard
+        client = dashboard.add_client()
+        if client is None:
+            self.send_error(503, "Too many dashboard clients")
+            return
+
+        try:
+            self.connection.settimeout(WRITE_TIMEOUT)
+            self.send_response(200)
+            self.send_header('Content-Type', 'text/event-stream')
+            self.send_header('Cache-Control', 'no-cache')
+            self.send_header('Access-Control-Allow-Origin', '*')
+            self.end_headers()
+            self.wfile.write(f"retry: {RETRY_MS}\n\n".encode('utf-8'))
+            self.wfile.flush()
+
+            while not client.closed:
+                events, skipped = client.take(KEEPALIVE_INTERVAL)
+                chunks = [f"event: skipped\ndata: {skipped}\n\n"] if skipped else []
+                chunks += events
+                self.wfile.write("".join(chunks or [": keepalive\n\n"]).encode('utf-8'))
+                self.wfile.flush()
+        except OSError:
+            pass  # Tab closed, or too slow to keep up
+        finally:
+            dashboard.remove_client(client)
+
+    def log_message(self, format, *args):
+        pass  # Keep the bridge console for the bridge
+
+DASHBOARD_PAGE = """<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<meta name="viewport" content="width=device-width, initial-scale=1">
+<title>Disaster Recon UAV - Live</title>
+<style>
+  body { font-family: sans-serif; margin: 2em; background: #111; color: #eee; }
+  table { border-collapse: collapse; }
+  td { padding: 0.3em 1em; font-size: 1.6em; }
+  td.value { font-family: monospace; text-align: right; min-width: 6em; }
+  #status { color: #999; }
+  .alert { color: #f44; }
+</style>
+</head>
+<body>
+<h1>Disaster Recon UAV <span id="device"></span></h1>
+<p id="status">Connecting...</p>
+<table>
+  <tr><td>Pitch</td><td class="value" id="pitch">-</td><td>&deg;</td></tr>
+  <tr><td>Roll</td><td class="value" id="roll">-</td><td>&deg;</td></tr>
+  <tr><td>Yaw</td><td class="value" id="yaw">-</td><td>&deg;</td></tr>
+  <tr><td>Distance</td><td class="value" id="distance">-</td><td>cm</td></tr>
+  <tr><td>Gas</td><td class="value" id="gas_level">-</td><td></td></tr>
+  <tr><td>Temperature</td><td class="value" id="temperature">-</td><td>&deg;C</td></tr>
+  <tr><td>Humidity</td><td class="value" id="humidity">-</td><td>%</td></tr>
+  <tr><td>State</td><td class="value" id="drone_state">-</td><td></td></tr>
+  <tr><td>Sensors down</td><td class="value" id="health">-</td><td></td></tr>
+</table>
+<script>
+  const states = ['OFF', 'IDLE', 'ACTIVE', 'ALERT', 'ERROR'];
+  const sensors = ['DHT11', 'MPU6050', 'HC-SR04'];  // SENSOR_NAMES order
+  const status = document.getElementById('status');
+  let count = 0, skipped = 0;
+  const events = new EventSource('events');
+  events.onopen = () => { status.textContent = 'Live'; };
+  events.onerror = () => { status.textContent = 'Reconnecting...'; };
+  events.addEventListener('skipped', (e) => { skipped += Number(e.data); });
+  events.addEventListener('sample', (e) => {
+    const sample = JSON.parse(e.data);
+    // Live updates carry only pitch, roll, yaw and distance
+    for (const key of ['pitch', 'roll', 'yaw', 'distance', 'gas_level', 'temperature', 'humidity']) {
+      if (key in sample) {
+        document.getElementById(key).textContent = sample[key];
+      }
+    }
+    if ('drone_state' in sample) {
+      const state = document.getElementById('drone_state');
+      state.textContent = states[sample.drone_state] || sample.drone_state;
+      state.className = 'value' + (sample.drone_state === 3 ? ' alert' : '');
+    }
+    if (sample.device !== undefined) {
+      document.getElementById('device').textContent = '#' + sample.device;
+    }
+    if (sample.health !== undefined) {
+      const down = sensors.filter((name, bit) => sample.health & (1 << bit));
+      const health = document.getElementById('health');
+      health.textContent = down.length ? down.join(', ') : 'none';
+      health.className = 'value' + (down.length ? ' alert' : '');
+    }
+    count++;
+    const time = new Date(sample.time * 1000).toLocaleTimeString();
+    status.textContent = `Live: ${count} samples, last at ${time}` + (skipped ? `, ${skipped} skipped` : '');
+  });
+</script>
+</body>
+</html>
+"""
@@ -0,0 +1,221 @@
+/*
+ * Serial Downlink Parser for Disaster Recon UAV
+ *
+ * Decodes what the Python bridge sends back, one byte at a time:
+ * - Data lines:    value1|value2|...|value8\r\n  (ThingSpeak fields)
+ * - Keyword lines: CLOUD_OK, CLOUD_FAIL, ...
+ *
+ * No heap, no String and no floats: bytes come straight out of the
+ * HardwareSerial RX ring buffer into fixed-point accumulators, and a
+ * whole line is stored as a QuantizedSample, in the units the UAV
+ * sends its own readings in.
+ *
+ * The bridge only sends the fields that changed (the others are left
+ * empty), plus a full line each time it reads the channel. CloudCache
+ * keeps when each field was last heard, so a value the bridge hasn't
+ * confirmed for CLOUD_DATA_STALE can be shown as stale.
+ */
+
+#ifndef DOWNLINK_H
+#define DOWNLINK_H
+
+#include "config.h"    // For CLOUD_DATA_STALE
+#include "telemetry.h" // For QuantizedSample and its quantisers
+#include <Arduino.h>
+
+#define DOWNLINK_FIELDS 8
+#define DOWNLINK_KEYWORD_SIZE 16 // Longest keyword + terminator
+#define DOWNLINK_MAX_DECIMALS 3  // Extra decimals are dropped
+
+// Parser states
+enum DownlinkState {
+  DL_LINE_START, // Nothing seen yet on this line
+  DL_DATA,       // Inside a |-separated data line
+  DL_KEYWORD,    // Inside a keyword line
+  DL_DISCARD     // Bad line, skip to the newline
+};
+
+// Events returned by feedDownlink()
+enum DownlinkEvent {
+  DOWNLINK_NONE,    // Line not complete yet
+  DOWNLINK_DATA,    // Data line complete, call storeDownlinkData()
+  DOWNLINK_KEYWORD  // Keyword line complete, see parser.keyword
+};
+
+struct DownlinkParser {
+  uint8_t state;
+  uint8_t field;        // Field being parsed
+  uint8_t fieldMask;    // Bit per field that had digits
+  bool negative;
+  bool fraction;        // Past the decimal point
+  uint8_t decimals[DOWNLINK_FIELDS];
+  int32_t mantissa[DOWNLINK_FIELDS];
+  char keyword[DOWNLINK_KEYWORD_SIZE];
+  uint8_t keywordLength;
+};
+
+DownlinkParser downlink;
+
+void resetDownlinkLine(DownlinkParser &parser) {
+  parser.state = DL_LINE_START;
+  parser.field = 0;
+  parser.fieldMask = 0;
+  parser.negative = false;
+  parser.fraction = false;
+  parser.keywordLength = 0;
+  parser.keyword[0] = '\0';
+}
+
+// Close the current field and move to the next one
+void endDownlinkField(DownlinkParser &parser) {
+  if (parser.field < DOWNLINK_FIELDS && parser.negative) {
+    parser.mantissa[parser.field] = -parser.mantissa[parser.field];
+  }
+  parser.field++;
+  parser.negative = false;
+  parser.fraction = false;
+  if (parser.field < DOWNLINK_FIELDS) {
+    parser.mantissa[parser.field] = 0;
+    parser.decimals[parser.field] = 0;
+  }
+}
+
+// Feed one byte from the serial port
+uint8_t feedDownlink(DownlinkParser &parser, char c) {
+  if (c == '\r') {
+    return DOWNLINK_NONE;
+  }
+
+  if (c == '\n') {
+    uint8_t event = DOWNLINK_NONE;
+    if (parser.state == DL_DATA) {
+      endDownlinkField(parser);
+      event = DOWNLINK_DATA;
+    } else if (parser.state == DL_KEYWORD) {
+      parser.keyword[parser.keywordLength] = '\0';
+      event = DOWNLINK_KEYWORD;
+    }
+    parser.state = DL_LINE_START; // Results stay readable until next byte
+    return event;
+  }
+
+  if (parser.state == DL_LINE_START) {
+    // The previous event has been handled by now
+    resetDownlinkLine(parser);
+    parser.mantissa[0] = 0;
+    parser.decimals[0] = 0;
+    parser.state = (isAlpha(c) || c == '_') ? DL_KEYWORD : DL_DATA;
+  }
+
+  switch (parser.state) {
+  case DL_KEYWORD:
+    if (parser.keywordLength < DOWNLINK_KEYWORD_SIZE - 1) {
+      parser.keyword[parser.keywordLength++] = c;
+    } else {
+      parser.state = DL_DISCARD; // Too long to be one of ours
+    }
+    break;
+
+  case DL_DATA:
+    if (c == '|') {
+      endDownlinkField(parser);
+    } else if (parser.field >= DOWNLINK_FIELDS) {
+      // Ignore anything past the last field
+    } else if (isDigit(c)) {
+      uint8_t f = parser.field;
+      if (!parser.fraction || parser.decimals[f] < DOWNLINK_MAX_DECIMALS) {
+        parser.mantissa[f] = parser.mantissa[f] * 10 + (c - '0');
+        if (parser.fraction) {
+          parser.decimals[f]++;
+        }
+      }
+      parser.fieldMask |= 1 << f;
+    } else if (c == '.') {
+      parser.fraction = true;
+    } else if (c == '-') {
+      parser.negative = true;
+    }
+    // Other characters are ignored, as before
+    break;
+  }
+
+  return DOWNLINK_NONE;
+}
+
+// Field value x 10^decimals, rounded half away from zero (only called
+// once the line is complete)
+int16_t downlinkFixed(const DownlinkParser &parser, uint8_t field,
+                      uint8_t decimals) {
+  static const int16_t scale[DOWNLINK_MAX_DECIMALS + 1] = {1, 10, 100, 1000};
+  int32_t value = parser.mantissa[field];
+  uint8_t have = parser.decimals[field];
+  if (have <= decimals) {
+    value *= scale[decimals - have];
+  } else {
+    int16_t divisor = scale[have - decimals];
+    value = (value + (value < 0 ? -divisor : divisor) / 2) / divisor;
+  }
+  return constrain(value, (int32_t)-INT16_MAX, (int32_t)INT16_MAX); // Not SAMPLE_INVALID
+}
+
+// Copy the fields of a completed data line (ThingSpeak field order);
+// empty fields keep their value
+void storeDownlinkData(const DownlinkParser &parser, QuantizedSample &data) {
+  for (uint8_t i = 0; i < DOWNLINK_FIELDS; i++) {
+    if (!(parser.fieldMask & (1 << i))) {
+      continue;
+    }
+    switch (i) {
+      case 0: data.field[FIELD_TEMPERATURE] = quantizeTemperature(downlinkFixed(parser, i, 1)); break;
+      case 1: data.field[FIELD_HUMIDITY] = quantizeHumidity(downlinkFixed(parser, i, 1)); break;
+      case 2: data.field[FIELD_GAS] = downlinkFixed(parser, i, 0); break;
+      case 3: {
+        int16_t distance = downlinkFixed(parser, i, 0);
+        data.field[FIELD_DISTANCE] = distance < 0 ? SAMPLE_INVALID : distance;
+        break;
+      }
+      case 4: data.state = downlinkFixed(parser, i, 0); break;
+      case 5: data.field[FIELD_PITCH] = downlinkFixed(parser, i, 1); break;
+      case 6: data.field[FIELD_ROLL] = downlinkFixed(parser, i, 1); break;
+      case 7: data.field[FIELD_YAW] = downlinkFixed(parser, i, 1); break;
+    }
+  }
+}
+
+// ==========================================
+// CLOUD CACHE
+// ==========================================
+
+struct CloudCache {
+  QuantizedSample sample;               // Last value of each field
+  unsigned long heard[WIRE_FIELD_COUNT]; // millis() it was last sent
+  uint8_t heardMask;                     // Bit per wire field ever sent
+};
+
+// ThingSpeak field (downlink order) to wire field (telemetry.h)
+const uint8_t downlinkWireField[DOWNLINK_FIELDS] PROGMEM = {
+    FIELD_TEMPERATURE, FIELD_HUMIDITY, FIELD_GAS,  FIELD_DISTANCE,
+    WIRE_STATE,        FIELD_PITCH,    FIELD_ROLL, FIELD_YAW,
+};
+
+// Store a completed data line and note which fields it refreshed
+void storeCloudData(const DownlinkParser &parser, CloudCache &cache,
+                    unsigned long now) {
+  storeDownlinkData(parser, cache.sample);
+  for (uint8_t i = 0; i < DOWNLINK_FIELDS; i++) {
+    if (parser.fieldMask & (1 << i)) {
+      uint8_t field = pgm_read_byte(&downlinkWireField[i]);
+      cache.heard[field] = now;
+      cache.heardMask |= 1 << field;
+    }
+  }
+}
+
+// Heard recently enough to show as current (field in wire order)
+bool cloudFieldFresh(const CloudCache &cache, uint8_t field,
+                     unsigned long now) {
+  return (cache.heardMask & (1 << field)) &&
+         now - cache.heard[field] < CLOUD_DATA_STALE;
+}
+
+#endif // DOWNLINK_H
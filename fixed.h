@@ -0,0 +1,167 @@
+/*
+ * Fixed-Point Math for Disaster Recon UAV
+ *
+ * The ATmega328P has no FPU: a float multiply is a library call and
+ * atan2() runs to thousands of cycles. Sensor and fusion code uses
+ * these integer forms instead:
+ * - q16_t:    16.16 fixed point, used for angles (65536 = 1°)
+ * - tenths_t: value x 10, the resolution SensorData and the wire use
+ * - atan2Q16(): CORDIC atan2 on raw int16 vectors, in Q16 degrees
+ * - q16Scale(): constant ratios turned into Q16 multipliers at
+ *   compile time, applied with scaleQ16()
+ *
+ * Floats are left at the edges. The DHT library returns its readings
+ * as floats (toTenths() converts them once), and printTenths()
+ * formats tenths without going through float at all.
+ */
+
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <Arduino.h>
+
+typedef int32_t q16_t;    // 16.16 fixed point
+typedef int16_t tenths_t; // Value x 10
+
+#define Q16_ONE 65536L
+#define TENTHS(x) ((x) * 10)
+
+// ==========================================
+// COMPILE-TIME CONSTANTS
+// ==========================================
+// constexpr, so the double arithmetic happens in the compiler and only
+// the integer result reaches the AVR.
+
+constexpr q16_t toQ16(double value) {
+  return (q16_t)(value * Q16_ONE + (value < 0 ? -0.5 : 0.5));
+}
+
+// Multiplier for a ratio in 0..1, see scaleQ16()
+constexpr uint16_t q16Scale(double ratio) {
+  return (uint16_t)(ratio * Q16_ONE + 0.5);
+}
+
+// value * ratio, rounded; factor = q16Scale(ratio)
+uint16_t scaleQ16(uint16_t value, uint16_t factor) {
+  return ((uint32_t)value * factor + 0x8000) >> 16;
+}
+
+// ==========================================
+// CONVERSIONS
+// ==========================================
+
+// Q16 to tenths, rounded half away from zero
+tenths_t q16ToTenths(q16_t value) {
+  if (value < 0) {
+    return -(tenths_t)((-value * 10 + 0x8000) >> 16);
+  }
+  return (tenths_t)((value * 10 + 0x8000) >> 16);
+}
+
+// The one float entry point, for library readings
+tenths_t toTenths(float value) {
+  return (tenths_t)(value * 10.0f + (value < 0 ? -0.5f : 0.5f));
+}
+
+// "12.3" (or "12" without the decimal, rounded), no float formatting
+void printTenths(Print &out, tenths_t value, bool showDecimal = true) {
+  uint16_t magnitude = value < 0 ? -(int32_t)value : value;
+  if (value < 0) {
+    out.print('-');
+  }
+  if (showDecimal) {
+    out.print(magnitude / 10);
+    out.print('.');
+    out.print(magnitude % 10);
+  } else {
+    out.print((magnitude + 5) / 10);
+  }
+}
+
+// ==========================================
+// ANGLES
+// ==========================================
+
+#define Q16_ONE_DEGREE Q16_ONE
+#define Q16_QUARTER_TURN (90L * Q16_ONE_DEGREE)
+#define Q16_HALF_TURN (180L * Q16_ONE_DEGREE)
+#define Q16_FULL_TURN (360L * Q16_ONE_DEGREE)
+
+// Wrap a Q16 angle difference into -180..180
+q16_t wrapHalfTurn(q16_t angle) {
+  while (angle > Q16_HALF_TURN)
+    angle -= Q16_FULL_TURN;
+  while (angle < -Q16_HALF_TURN)
+    angle += Q16_FULL_TURN;
+  return angle;
+}
+
+// ==========================================
+// CORDIC ATAN2
+// ==========================================
+// Vectoring mode: rotate (x, y) onto the x axis by +-atan(2^-i) steps
+// and add up the rotations. Inputs are first turned into the right
+// half-plane (where CORDIC converges) and scaled to 0x1000..0x1FFF, so
+// int16 math can't overflow (the vector grows 1.65x) and small vectors
+// keep their resolution. Within 0.07° of atan2() over the whole int16
+// range; each step is two 16-bit shifts and adds, no multiply or divide.
+
+#define CORDIC_ITERATIONS 14 // Last step is atan(2^-13) = 0.007°
+
+// atan(2^-i) in Q16 degrees
+const q16_t cordicAngles[CORDIC_ITERATIONS] PROGMEM = {
+    2949120, 1740967, 919879, 466945, 234379, 117304, 58666,
+    29335,   14668,   7334,   3667,   1833,   917,    458};
+
+// atan2(y, x) in Q16 degrees, -180..180 (0 for the zero vector)
+q16_t atan2Q16(int16_t y, int16_t x) {
+  int32_t vx = x;
+  int32_t vy = y;
+  q16_t angle = 0;
+
+  if (vx < 0) {
+    // Rotate by -+90° into the right half-plane
+    int32_t oldX = vx;
+    if (vy >= 0) {
+      vx = vy;
+      vy = -oldX;
+      angle = Q16_QUARTER_TURN;
+    } else {
+      vx = -vy;
+      vy = oldX;
+      angle = -Q16_QUARTER_TURN;
+    }
+  }
+
+  if (vx == 0 && vy == 0) {
+    return 0;
+  }
+  while (vx >= 0x2000 || vy >= 0x2000 || vy < -0x2000) {
+    vx >>= 1;
+    vy >>= 1;
+  }
+  while (vx < 0x1000 && vy < 0x1000 && vy > -0x1000) {
+    vx <<= 1;
+    vy <<= 1;
+  }
+
+  int16_t cx = vx;
+  int16_t cy = vy;
+  for (uint8_t i = 0; i < CORDIC_ITERATIONS; i++) {
+    int16_t dx = cx >> i;
+    int16_t dy = cy >> i;
+    q16_t step = (q16_t)pgm_read_dword(&cordicAngles[i]);
+    if (cy > 0) {
+      cx += dy;
+      cy -= dx;
+      angle += step;
+    } else {
+      cx -= dy;
+      cy += dx;
+      angle -= step;
+    }
+  }
+  return angle;
+}
+
+#endif // FIXED_H
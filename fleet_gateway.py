@@ -0,0 +1,388 @@
+#!/usr/bin/env python3
+"""
+===================================================
+Fleet Gateway - Disaster Recon UAV
+===================================================
+
+One process for several airframes, instead of one bridge per UAV:
+
+    link worker (COM7) --+                                   +--> UAV 1 channel
+    link worker (COM8) --+--> spool --> upload scheduler ----+--> UAV 2 channel
+    link worker (...)  --+   (SQLite)         |              +--> ...
+          ^                                   |
+          +-- read-back lines, to the port each UAV was last heard on
+
+1. Each serial port gets its own worker process, so parsing scales
+   across cores. It runs the bridge's SerialReader, so the handshake,
+   baud switch, frames and CSV behave as in thingspeak_bidirectional.py
+2. Samples are tagged with the DEVICE_ID the sketch sends (config.h)
+   and go into one shared spool, with a queue per device
+3. One scheduler paces the uploads per channel (each channel has its
+   own ThingSpeak rate limit and backoff). Requests run on a small thread
+   pool, so a slow or failing channel doesn't hold up the others
+4. Each channel keeps a cache of its last entry. An upload writes
+   through it and the fields that changed go straight back to the UAV,
+   on the port it was last heard on; the channel itself is only read
+   every POLL_INTERVAL, for changes made by anyone else
+
+A port may carry several airframes (e.g. a radio base station). Uplink
+is kept apart by device ID, but read-back lines reach every UAV on
+that port.
+
+Channels come from FLEET_CHANNELS in channel_info.py (see
+channel_info_template.py). Settings not listed here are the bridge's.
+===================================================
+"""
+
+import multiprocessing
+import queue
+import signal
+import sys
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import thingspeak_bidirectional as bridge
+from dashboard import Dashboard
+from spool import Spool
+
+# ===================================================
+# CONFIGURATION
+# ===================================================
+
+try:
+    from channel_info import FLEET_CHANNELS
+except ImportError:
+    # channel_info.py from before the gateway: UAV 1 gets the bridge's channel
+    FLEET_CHANNELS = {
+        1: {
+            "channel_id": bridge.CHANNEL_ID,
+            "write_api_key": bridge.WRITE_API_KEY,
+            "read_api_key": bridge.READ_API_KEY
+        }
+    }
+
+# Serial port: device ID assumed for a sketch that doesn't send one
+FLEET_PORTS = {
+    'COM7': 1,
+    'COM8': 2,
+}
+
+SPOOL_PATH = 'fleet_spool.db'  # Shared by all UAVs, one queue each
+UPLOAD_WORKERS = 4  # HTTP requests in flight across all channels
+QUEUE_POLL = 0.5  # seconds a queue wait may block (keeps shutdown quick)
+RECONNECT_DELAY = 5  # seconds between attempts to reopen a lost port
+STOP_TIMEOUT = 5  # seconds a link worker gets to exit before it's killed
+
+# ===================================================
+# LINK WORKERS (one process per serial port)
+# ===================================================
+
+class PrefixedOutput:
+    """stdout that starts each line with the port name"""
+
+    def __init__(self, stream, prefix):
+        self.stream = stream
+        self.prefix = prefix
+        self.line_start = True
+
+    def write(self, text):
+        for part in text.splitlines(keepends=True):
+            if self.line_start:
+                self.stream.write(self.prefix)
+            self.stream.write(part)
+            self.line_start = part.endswith(('\n', '\r'))
+        return len(text)
+
+    def flush(self):
+        self.stream.flush()
+
+class LinkReader(bridge.SerialReader):
+    """The bridge's serial reader, handing samples to the gateway"""
+
+    def __init__(self, port, default_device, link, samples, stop):
+        super().__init__(link, None, stop)
+        self.port = port
+        self.default_device = default_device
+        self.samples = samples
+
+    def store(self, sample_time, data, live=False):
+        device = data.pop('device', self.default_device)
+        self.samples.put((device, self.port, sample_time, data, live))
+
+    def store_live(self, sample_time, data):
+        self.store(sample_time, data, live=True)
+
+def link_worker(port, default_device, samples, downlink, stop):
+    """Runs one serial link until stop is set, reopening it if it's lost"""
+    signal.signal(signal.SIGINT, signal.SIG_IGN)  # The gateway stops us with `stop`
+    sys.stdout = PrefixedOutput(sys.stdout, f"[{port}] ")
+
+    while not stop.is_set():
+        ser = bridge.connect_serial(port)
+        if not ser:
+            stop.wait(RECONNECT_DELAY)
+            continue
+
+        link = bridge.SerialLink(ser)
+        link_stop = threading.Event()  # Set by the reader on a serial error
+        reader = LinkReader(port, default_device, link, samples, link_stop)
+        reader.start()
+
+        while not stop.is_set() and reader.is_alive():
+            try:
+                retrieved_data = downlink.get(timeout=QUEUE_POLL)
+            except queue.Empty:
+                continue
+            bridge.send_to_arduino(link, retrieved_data)
+
+        link_stop.set()
+        reader.join(timeout=bridge.SERIAL_TIMEOUT + 1)
+        ser.close()
+        if not stop.is_set():
+            print(f"  ⚠️  Link lost, reopening in {RECONNECT_DELAY} seconds")
+            stop.wait(RECONNECT_DELAY)
+
+# ===================================================
+# GATEWAY STAGES (threads in the main process)
+# ===================================================
+
+class Collector(threading.Thread):
+    """Moves samples from the link workers into the spool (and the dashboard)"""
+
+    def __init__(self, samples, spool, routes, stop, dashboard=None):
+        super().__init__(name="collector", daemon=True)
+        self.samples = samples
+        self.spool = spool
+        self.dashboard = dashboard
+        self.routes = routes  # device -> port it was last heard on
+        self.stop = stop
+
+    def run(self):
+        while not self.stop.is_set():
+            try:
+                self.store(*self.samples.get(timeout=QUEUE_POLL))
+            except queue.Empty:
+                pass
+
+        # The workers have exited: keep what they sent last
+        try:
+            while True:
+                self.store(*self.samples.get_nowait())
+        except queue.Empty:
+            pass
+
+    def store(self, device, port, sample_time, data, live):
+        if live:
+            # Between samples, for the dashboard only
+            if self.dashboard:
+                self.dashboard.publish(sample_time, data, device)
+            return
+
+        if self.routes.get(device) != port:
+            if device in FLEET_CHANNELS:
+                print(f"  🛩  UAV {device} on {port}")
+            else:
+                print(f"  ⚠️  UAV {device} on {port} has no channel in FLEET_CHANNELS, spooling its samples")
+            self.routes[device] = port
+
+        self.spool.append(sample_time, data, device)
+        if self.dashboard:
+            self.dashboard.publish(sample_time, data, device)
+
+class ChannelState:
+    """Upload pacing and read-back timing of one UAV's channel"""
+
+    def __init__(self, device, channel):
+        self.device = device
+        self.channel = channel
+        self.bucket = bridge.TokenBucket(bridge.WRITE_RATE, bridge.WRITE_BURST)
+        self.backoff_until = 0
+        self.backoff = bridge.RETRY_BACKOFF
+        self.read_due = time.monotonic() + bridge.POLL_INTERVAL
+        self.cache = bridge.ChannelCache()
+        self.busy = False  # A request for this channel is in flight
+
+class UploadScheduler(threading.Thread):
+    """Paces every channel's bulk writes and read-backs on one thread pool"""
+
+    def __init__(self, session, spool, routes, downlinks, stop):
+        super().__init__(name="upload-scheduler", daemon=True)
+        self.session = session
+        self.spool = spool
+        self.routes = routes
+        self.downlinks = downlinks  # port -> queue of lines for its worker
+        self.stop = stop
+        self.channels = [ChannelState(device, channel) for device, channel in FLEET_CHANNELS.items()]
+        self.pool = ThreadPoolExecutor(UPLOAD_WORKERS, thread_name_prefix="upload")
+
+    def run(self):
+        for device in self.spool.devices():
+            print(f"  📦 UAV {device}: {self.spool.pending(device)} samples left in the spool from last run")
+
+        while not self.stop.is_set():
+            # Samples keep arriving in the spool meanwhile
+            self.stop.wait(max(self.schedule(), 0.05))
+
+        self.pool.shutdown(wait=True)
+        for device in self.spool.devices():
+            print(f"  📦 UAV {device}: {self.spool.pending(device)} samples kept in the spool for next run")
+
+    def schedule(self):
+        """Start whatever is due; returns seconds until something may be"""
+        now = time.monotonic()
+        wait = QUEUE_POLL
+
+        for state in self.channels:
+            if state.busy:
+                continue
+
+            upload_wait = max(state.bucket.wait_time(), state.backoff_until - now)
+            if upload_wait <= 0 and self.spool.pending(state.device):
+                self.submit(state, self.flush)
+            elif now >= state.read_due:
+                self.submit(state, self.poll)
+            else:
+                wait = min(wait, state.read_due - now)
+
+        return wait
+
+    def submit(self, state, request):
+        state.busy = True
+        self.pool.submit(self.run_request, state, request)
+
+    def run_request(self, state, request):
+        try:
+            request(state)
+        finally:
+            state.busy = False
+
+    def flush(self, state):
+        device = state.device
+        rows = self.spool.peek(bridge.BULK_MAX_SAMPLES, device)
+        samples = [(sample_time, data) for _, sample_time, data in rows]
+        state.bucket.take()
+
+        success, message = bridge.upload_to_thingspeak(self.session, samples, state.channel)
+
+        if success:
+            self.spool.commit(rows[-1][0], device)
+            state.backoff = bridge.RETRY_BACKOFF
+            # A read right now could still return the entry before ours
+            state.read_due = max(state.read_due, time.monotonic() + bridge.READ_DELAY)
+            print(f"  ✓ UAV {device}: uploaded {message}, oldest {time.time() - samples[0][0]:.1f}s old")
+            state.cache.write_through(samples[-1][1])
+            self.forward(state, "cache")
+            return
+
+        # Leave the batch in the spool and try again later, backing off exponentially
+        print(f"  ✗ UAV {device}: {message}")
+        print(f"  ⏳ UAV {device}: retrying in {state.backoff} seconds ({self.spool.pending(device)} samples spooled)...")
+        state.backoff_until = time.monotonic() + state.backoff
+        state.backoff = min(state.backoff * 2, bridge.MAX_BACKOFF)
+        if self.spool.dropped:
+            print(f"  ⚠️  Spool full: {self.spool.dropped} oldest samples dropped so far")
+
+    def poll(self, state):
+        state.read_due = time.monotonic() + bridge.POLL_INTERVAL
+        port = self.routes.get(state.device)
+        if port is None:
+            return  # Not heard from yet, nowhere to send it
+
+        retrieved_data = bridge.read_from_thingspeak(self.session, state.channel)
+        if retrieved_data:
+            state.cache.update(retrieved_data)
+            self.forward(state, "channel", full=True)
+
+    def forward(self, state, source, full=False):
+        """Send the UAV what changed in its channel (everything if full)"""
+        port = self.routes.get(state.device)
+        retrieved_data = state.cache.downlink(full) if port else None
+        if not retrieved_data:
+            return  # Not heard from yet, or nothing changed
+        self.downlinks[port].put(retrieved_data)
+        print(f"  📡 UAV {state.device}: {' | '.join(field or '-' for field in retrieved_data)} "
+              f"(from {source}), sent to {port}")
+
+# ===================================================
+# MAIN PROGRAM
+# ===================================================
+
+def print_header():
+    """Print startup header"""
+    print("=" * 60)
+    print(" DISASTER RECON UAV - Fleet Gateway")
+    print(" Student ID:", bridge.ID)
+    print("=" * 60)
+    for port, device in FLEET_PORTS.items():
+        print(f"Serial Port: {port} @ {bridge.BAUD_RATE} baud (UAV {device} unless the sketch says otherwise)")
+    for device, channel in FLEET_CHANNELS.items():
+        print(f"UAV {device}: ThingSpeak Channel {channel['channel_id']}")
+    print(f"Bulk Upload: every {1 / bridge.WRITE_RATE:.0f} seconds per channel, up to {bridge.BULK_MAX_SAMPLES} samples")
+    print("=" * 60)
+    print()
+
+def main():
+    print_header()
+    sys.stdout.flush()  # Don't let the workers inherit buffered output
+
+    # Workers first, before this process has any threads of its own
+    samples = multiprocessing.Queue()
+    downlinks = {port: multiprocessing.Queue() for port in FLEET_PORTS}
+    worker_stop = multiprocessing.Event()
+    workers = [
+        multiprocessing.Process(
+            target=link_worker, name=f"link-{port}", daemon=True,
+            args=(port, device, samples, downlinks[port], worker_stop))
+        for port, device in FLEET_PORTS.items()
+    ]
+    for worker in workers:
+        worker.start()
+
+    session = bridge.make_session(UPLOAD_WORKERS)
+    spool = Spool(SPOOL_PATH, bridge.SPOOL_MAX_SAMPLES)
+    routes = {}
+    stop = threading.Event()
+
+    dashboard = None
+    if bridge.DASHBOARD_PORT:
+        dashboard = Dashboard(bridge.DASHBOARD_HOST, bridge.DASHBOARD_PORT)
+        if not dashboard.start():
+            dashboard = None
+
+    collector = Collector(samples, spool, routes, stop, dashboard)
+    scheduler = UploadScheduler(session, spool, routes, downlinks, stop)
+    collector.start()
+    scheduler.start()
+
+    try:
+        # The stages do the work; wake up now and then for Ctrl+C
+        while not stop.wait(1):
+            pass
+
+    except KeyboardInterrupt:
+        print("\n\n✓ Program interrupted by user")
+
+    finally:
+        # Links first, so the collector can take their last samples
+        worker_stop.set()
+        for worker in workers:
+            worker.join(timeout=STOP_TIMEOUT)
+            if worker.is_alive():
+                worker.terminate()
+
+        stop.set()
+        collector.join(timeout=STOP_TIMEOUT)
+        scheduler.join(timeout=bridge.HTTP_TIMEOUT + 1)
+        if dashboard:
+            dashboard.stop()
+        session.close()
+        spool.close()
+        print("\nGoodbye!")
+
+# ===================================================
+# ENTRY POINT
+# ===================================================
+
+if __name__ == "__main__":
+    main()
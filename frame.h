@@ -0,0 +1,116 @@
+/*
+ * Binary Frame Layer for Disaster Recon UAV
+ *
+ * Shared by telemetry, window statistics and log messages:
+ *
+ *   0xA5 | ver<<4|type | seq | len | payload[len] | crc16 (LE)
+ *
+ * - CRC16 is CRC-16/XMODEM over ver/type..payload
+ *   (Python: binascii.crc_hqx(data, 0))
+ * - Multi-byte fields are little-endian
+ * - seq increments per frame so the bridge can count drops
+ *
+ * Text lines can share the link: 0xA5 never appears in the ASCII
+ * we print.
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <Arduino.h>
+#if defined(__AVR__)
+#include <util/crc16.h>
+#endif
+
+#define FRAME_SYNC 0xA5
+#define FRAME_VERSION 1
+#define FRAME_HEADER_SIZE 4 // sync, ver/type, seq, len
+#define FRAME_CRC_SIZE 2
+#define FRAME_MAX_PAYLOAD 58 // Frame fits the 64-byte serial TX buffer
+
+// Frame types (low nibble of the ver/type byte)
+#define FRAME_TELEMETRY 0x1
+#define FRAME_WINDOW 0x2 // Window statistics, see history.h
+#define FRAME_LOG 0x3    // Log message, see log.h
+#define FRAME_STATS 0x4  // Profiler statistics, see profile.h
+#define FRAME_TELEMETRY_DELTA 0x5 // Telemetry deltas, see telemetry.h
+#define FRAME_LIVE 0x6 // Live attitude and distance, see telemetry.h
+#define FRAME_HISTORY 0x7 // History ring, see history.h
+
+// ==========================================
+// CRC16
+// ==========================================
+
+uint16_t crc16Update(uint16_t crc, uint8_t value) {
+#if defined(__AVR__)
+  return _crc_xmodem_update(crc, value);
+#else
+  crc ^= (uint16_t)value << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+#endif
+}
+
+// ==========================================
+// FRAME BUILDER
+// ==========================================
+
+struct FrameWriter {
+  uint8_t buffer[FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE];
+  uint8_t length;
+};
+
+uint8_t frameSequence = 0;
+
+void frameBegin(FrameWriter &frame, uint8_t type) {
+  frame.buffer[0] = FRAME_SYNC;
+  frame.buffer[1] = (FRAME_VERSION << 4) | (type & 0x0F);
+  frame.buffer[2] = frameSequence++;
+  frame.buffer[3] = 0; // Filled in by frameSend()
+  frame.length = FRAME_HEADER_SIZE;
+}
+
+void frameU8(FrameWriter &frame, uint8_t value) {
+  if (frame.length < FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD) {
+    frame.buffer[frame.length++] = value;
+  }
+}
+
+void frameU16(FrameWriter &frame, uint16_t value) {
+  frameU8(frame, value & 0xFF);
+  frameU8(frame, value >> 8);
+}
+
+void frameI16(FrameWriter &frame, int16_t value) {
+  frameU16(frame, (uint16_t)value);
+}
+
+void frameU32(FrameWriter &frame, uint32_t value) {
+  frameU16(frame, value & 0xFFFF);
+  frameU16(frame, value >> 16);
+}
+
+// True if a frame with this payload fits in the serial TX buffer now,
+// i.e. frameSend() will not block
+bool frameRoom(uint8_t payloadLength) {
+  return Serial.availableForWrite() >=
+         FRAME_HEADER_SIZE + payloadLength + FRAME_CRC_SIZE;
+}
+
+// Finish the frame (length + CRC) and queue it on the serial port
+void frameSend(FrameWriter &frame) {
+  frame.buffer[3] = frame.length - FRAME_HEADER_SIZE;
+
+  uint16_t crc = 0;
+  for (uint8_t i = 1; i < frame.length; i++) {
+    crc = crc16Update(crc, frame.buffer[i]);
+  }
+  frame.buffer[frame.length++] = crc & 0xFF;
+  frame.buffer[frame.length++] = crc >> 8;
+
+  Serial.write(frame.buffer, frame.length);
+}
+
+#endif // FRAME_H
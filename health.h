@@ -0,0 +1,231 @@
+/*
+ * Sensor Health and Watchdog for Disaster Recon UAV
+ *
+ * Keeps a failing part from stalling or confusing everything else:
+ * - Each sensor that can tell it failed (DHT11, MPU6050, HC-SR04)
+ *   reports every read to sensorResult(). HEALTH_FAULT_STREAK failures
+ *   in a row mark it down: it is skipped, and only retried after a
+ *   delay that doubles up to HEALTH_RETRY_MAX, so a dead part stops
+ *   costing its timeout on every pass. Until it answers again the
+ *   DHT11 fields stay SENSOR_ERROR_TENTHS and the distance -1, as the
+ *   failed reads left them; the fused attitude is frozen at its last
+ *   value (nothing to fuse)
+ * - healthFlags (a bit per sensor that is down) goes out with every
+ *   sample. A DHT11 or HC-SR04 fault is only reported; the MPU6050 is
+ *   flight-critical (HEALTH_CRITICAL_SENSORS), and while it is down the
+ *   UAV holds STATE_ERROR, motor off, unless a hazard is showing
+ *   (motor_control.h)
+ * - I2C transfers give up after I2C_TIMEOUT_US instead of waiting
+ *   forever, and recoverI2CBus() clocks a slave stuck mid-byte off
+ *   the bus before the MPU is set up again
+ * - The AVR watchdog is kicked after every scheduler pass. If a pass
+ *   hangs, its interrupt records the task that was running (kept
+ *   across the reset) and the next timeout resets the board
+ *
+ * The counters go to the bridge as the STATS_HEALTH page (profile.h).
+ */
+
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include "config.h"
+#include "log.h"
+#include <Arduino.h>
+#include <Wire.h>
+
+#if defined(__AVR__)
+#include <avr/wdt.h>
+#endif
+
+// Sensors with health tracking (names in telemetry_protocol.py)
+enum SensorId : uint8_t { SENSOR_DHT, SENSOR_MPU, SENSOR_RANGING, SENSOR_COUNT };
+
+struct SensorHealth {
+  uint16_t reads;        // Since boot (saturated)
+  uint16_t failures;     // Since boot (saturated)
+  uint8_t streak;        // Failures in a row
+  uint16_t retryDelay;   // ms before the next retry, doubled per failure
+  unsigned long retryAt; // millis() of the next retry (while down)
+};
+
+// The UAV can't fly safely without these: one of them down means
+// STATE_ERROR, motor off (the others are only reported)
+#define HEALTH_CRITICAL_SENSORS (1 << SENSOR_MPU)
+
+SensorHealth sensorHealth[SENSOR_COUNT];
+uint8_t healthFlags = 0; // Bit per sensor that is down, sent with every sample
+
+// ==========================================
+// SENSOR HEALTH
+// ==========================================
+
+bool sensorHealthy(uint8_t sensor) { return !(healthFlags & (1 << sensor)); }
+
+bool criticalSensorDown() { return healthFlags & HEALTH_CRITICAL_SENSORS; }
+
+// Healthy sensors are always due; one that is down once its retry is
+bool sensorDue(uint8_t sensor, unsigned long now) {
+  return sensorHealthy(sensor) ||
+         (long)(now - sensorHealth[sensor].retryAt) >= 0;
+}
+
+// Skip the sensor until now + retryDelay, then wait twice as long
+void scheduleSensorRetry(SensorHealth &health, unsigned long now) {
+  health.retryAt = now + health.retryDelay;
+  unsigned long next = (unsigned long)health.retryDelay * 2;
+  health.retryDelay = next > HEALTH_RETRY_MAX ? HEALTH_RETRY_MAX : next;
+}
+
+// Mark a sensor down now (e.g. missing at boot)
+void sensorDown(uint8_t sensor, unsigned long now) {
+  SensorHealth &health = sensorHealth[sensor];
+  if (sensorHealthy(sensor)) {
+    healthFlags |= 1 << sensor;
+    health.retryDelay = HEALTH_RETRY_MIN;
+    LOG_WARN(LOG_TAG_SENSOR, F("Sensor down: "), (long)sensor);
+  }
+  scheduleSensorRetry(health, now);
+}
+
+// Report one read (or probe)
+void sensorResult(uint8_t sensor, bool ok, unsigned long now) {
+  SensorHealth &health = sensorHealth[sensor];
+  if (health.reads < 0xFFFF) {
+    health.reads++;
+  }
+
+  if (ok) {
+    health.streak = 0;
+    if (!sensorHealthy(sensor)) {
+      healthFlags &= ~(1 << sensor);
+      LOG_INFO(LOG_TAG_SENSOR, F("Sensor recovered: "), (long)sensor);
+    }
+    return;
+  }
+
+  if (health.failures < 0xFFFF) {
+    health.failures++;
+  }
+  if (health.streak < 0xFF) {
+    health.streak++;
+  }
+  if (health.streak >= HEALTH_FAULT_STREAK || !sensorHealthy(sensor)) {
+    sensorDown(sensor, now); // Down, or a retry failed: back off again
+  }
+}
+
+// ==========================================
+// I2C BUS
+// ==========================================
+
+uint16_t i2cRecoveries = 0;
+uint16_t imuOverflows = 0; // MPU FIFO or ring overruns: samples lost (sensors.h)
+
+// Clock and timeout; Wire.begin() (which mpu.begin() also calls)
+// resets the clock, so this runs after each one
+void configureI2C() {
+  Wire.setClock(I2C_CLOCK);
+#if defined(WIRE_HAS_TIMEOUT)
+  Wire.setWireTimeout(I2C_TIMEOUT_US, true); // Reset the TWI on a timeout
+#endif
+}
+
+// A slave reset or glitched mid-byte keeps SDA low and every transfer
+// fails. Clock it through the rest of its byte (9 pulses at most),
+// send a STOP and restart the TWI. Pins are driven open-drain: low,
+// or released to the modules' pull-ups.
+void recoverI2CBus() {
+  Wire.end();
+#if defined(__AVR__)
+  pinMode(SDA, INPUT);
+  pinMode(SCL, INPUT);
+  digitalWrite(SDA, LOW);
+  digitalWrite(SCL, LOW);
+  for (uint8_t i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+    pinMode(SCL, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(SCL, INPUT);
+    delayMicroseconds(5);
+  }
+  // STOP: SDA rises while SCL is high
+  pinMode(SDA, OUTPUT);
+  delayMicroseconds(5);
+  pinMode(SDA, INPUT);
+  delayMicroseconds(5);
+#endif
+  Wire.begin();
+  configureI2C();
+  if (i2cRecoveries < 0xFFFF) {
+    i2cRecoveries++;
+  }
+}
+
+// ==========================================
+// WATCHDOG
+// ==========================================
+// Interrupt + reset mode: the first timeout runs WDT_vect, which
+// blames watchdogTask; the second (if the pass is still stuck)
+// resets. The record lives in .noinit, so it survives the reset and
+// is only cleared at power-on (wrong magic).
+
+#define WATCHDOG_NO_TASK 0xFF
+#define WATCHDOG_MAGIC 0x5744 // "WD"
+
+struct WatchdogRecord {
+  uint16_t magic;
+  uint8_t bites;    // Timeouts since power-on (saturated)
+  uint8_t lastTask; // Task running at the last one
+};
+
+#if defined(__AVR__)
+WatchdogRecord watchdogRecord __attribute__((section(".noinit")));
+#else
+WatchdogRecord watchdogRecord;
+#endif
+
+volatile uint8_t watchdogTask = WATCHDOG_NO_TASK; // Set by runTasks()
+
+#if defined(__AVR__)
+ISR(WDT_vect) {
+  if (watchdogRecord.bites < 0xFF) {
+    watchdogRecord.bites++;
+  }
+  watchdogRecord.lastTask = watchdogTask;
+}
+#endif
+
+// First thing in setup(): a watchdog reset leaves it running at 16 ms
+void stopWatchdog() {
+#if defined(__AVR__)
+  MCUSR = 0; // WDRF would force it back on
+  wdt_disable();
+#endif
+  if (watchdogRecord.magic != WATCHDOG_MAGIC) {
+    watchdogRecord.magic = WATCHDOG_MAGIC;
+    watchdogRecord.bites = 0;
+    watchdogRecord.lastTask = WATCHDOG_NO_TASK;
+  }
+}
+
+// Last thing in setup(), after the slow initialisation
+void startWatchdog() {
+  if (watchdogRecord.bites > 0) {
+    LOG_WARN(LOG_TAG_SYS, F("Watchdog timeouts since power-on: "),
+             (long)watchdogRecord.bites);
+    LOG_WARN(LOG_TAG_SYS, F("Last one in task: "), (long)watchdogRecord.lastTask);
+  }
+#if defined(__AVR__) && WATCHDOG_ENABLED
+  wdt_enable(WDTO_1S);
+  WDTCSR |= _BV(WDIE);
+#endif
+}
+
+// After every scheduler pass
+void kickWatchdog() {
+#if defined(__AVR__) && WATCHDOG_ENABLED
+  wdt_reset();
+  WDTCSR |= _BV(WDIE); // Cleared by the interrupt: interrupt first again
+#endif
+}
+
+#endif // HEALTH_H
@@ -0,0 +1,269 @@
+/*
+ * Sample History for Disaster Recon UAV
+ *
+ * Keeps what happens between reports instead of only the latest value:
+ * - A ring of the last HISTORY_SIZE quantised samples, packed
+ * - Running min/max/mean/variance per field for the current window,
+ *   updated as each sample is recorded (no rescans)
+ *
+ * The window is reported every WINDOW_SAMPLES samples and then
+ * restarted: as a FRAME_WINDOW frame in binary telemetry mode, as
+ * WINDOW: text lines next to the CSV samples otherwise. The ring goes
+ * out as FRAME_HISTORY frames when the bridge sends HISTORY (it does
+ * when the UAV enters STATE_ALERT, to show what led up to it).
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "config.h"
+#include "telemetry.h" // For QuantizedSample and the frame builder
+#include <Arduino.h>
+
+// ==========================================
+// SAMPLE RING
+// ==========================================
+
+PackedSample historyRing[HISTORY_SIZE];
+uint8_t historyHead = 0;  // Next slot to write
+uint8_t historyCount = 0; // Valid samples in the ring
+
+void recordHistory(const QuantizedSample &sample) {
+  packSample(sample, historyRing[historyHead]);
+  historyHead = (historyHead + 1) % HISTORY_SIZE;
+  if (historyCount < HISTORY_SIZE) {
+    historyCount++;
+  }
+}
+
+// age 0 = newest sample; caller checks age < historyCount
+void historySample(uint8_t age, QuantizedSample &out) {
+  unpackSample(
+      historyRing[(historyHead + HISTORY_SIZE - 1 - age) % HISTORY_SIZE], out);
+}
+
+// ==========================================
+// WINDOW STATISTICS
+// ==========================================
+// Sums are taken relative to the first value of the window so the
+// sum of squares stays inside 32 bits: variance = (S2 - S1^2/n) / n.
+
+struct FieldStats {
+  int16_t min;
+  int16_t max;
+  int16_t offset;      // First value in the window
+  int32_t sum;         // Sum of (value - offset)
+  uint32_t sumSquares; // Sum of (value - offset)^2
+  uint8_t count;       // Valid values (sensor errors are skipped)
+};
+
+#define WINDOW_MAX_SAMPLES 0xFF // The counts are 8-bit
+
+FieldStats windowStats[FIELD_COUNT];
+uint8_t windowSamples = 0;
+uint8_t windowLineField = 0xFF; // Next WINDOW: line to print; 0xFF = none due
+
+void resetWindow() {
+  memset(windowStats, 0, sizeof(windowStats));
+  windowSamples = 0;
+}
+
+void addToWindow(const QuantizedSample &sample) {
+  if (windowSamples == WINDOW_MAX_SAMPLES) {
+    resetWindow(); // Never got sent: start over with recent samples
+  }
+  windowSamples++;
+
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    int16_t value = sample.field[i];
+    if (value == SAMPLE_INVALID) {
+      continue;
+    }
+
+    FieldStats &stats = windowStats[i];
+    if (stats.count == 0) {
+      stats.min = value;
+      stats.max = value;
+      stats.offset = value;
+    } else if (value < stats.min) {
+      stats.min = value;
+    } else if (value > stats.max) {
+      stats.max = value;
+    }
+
+    int32_t delta = (int32_t)value - stats.offset;
+    uint32_t magnitude = delta < 0 ? -delta : delta;
+    stats.sum += delta;
+    stats.sumSquares += magnitude * magnitude;
+    stats.count++;
+  }
+}
+
+int16_t windowMin(const FieldStats &stats) {
+  return stats.count == 0 ? SAMPLE_INVALID : stats.min;
+}
+
+int16_t windowMax(const FieldStats &stats) {
+  return stats.count == 0 ? SAMPLE_INVALID : stats.max;
+}
+
+int16_t windowMean(const FieldStats &stats) {
+  if (stats.count == 0) {
+    return SAMPLE_INVALID;
+  }
+  int32_t sum = stats.sum;
+  int32_t half = sum < 0 ? -(stats.count / 2) : stats.count / 2;
+  return stats.offset + (int16_t)((sum + half) / stats.count);
+}
+
+uint16_t windowStdDev(const FieldStats &stats) {
+  if (stats.count < 2) {
+    return 0;
+  }
+  float mean = (float)stats.sum / stats.count;
+  float variance = (float)stats.sumSquares / stats.count - mean * mean;
+  return variance > 0 ? (uint16_t)(sqrt(variance) + 0.5f) : 0;
+}
+
+// Sample the current data into the ring and the window
+void recordSample(const SensorData &data, int state) {
+  QuantizedSample sample;
+  quantizeSample(data, state, sample);
+  recordHistory(sample);
+  if (windowLineField == 0xFF) {
+    addToWindow(sample); // Else the lines still to go would disagree
+  }
+}
+
+// ==========================================
+// WINDOW FRAME
+// ==========================================
+// Payload (57 bytes): uint8 sample count, then per field in SampleField
+// order: int16 min, int16 max, int16 mean, uint16 std dev (wire units).
+// Fields with no valid value report SAMPLE_INVALID for min/max/mean.
+
+#define WINDOW_PAYLOAD_SIZE (1 + FIELD_COUNT * 8)
+
+// Returns false (and keeps the window) if the TX buffer has no room yet
+bool sendWindowFrame() {
+  if (!frameRoom(WINDOW_PAYLOAD_SIZE)) {
+    return false;
+  }
+
+  FrameWriter frame;
+  frameBegin(frame, FRAME_WINDOW);
+  frameU8(frame, windowSamples);
+
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    const FieldStats &stats = windowStats[i];
+    frameI16(frame, windowMin(stats));
+    frameI16(frame, windowMax(stats));
+    frameI16(frame, windowMean(stats));
+    frameU16(frame, windowStdDev(stats));
+  }
+
+  frameSend(frame);
+  resetWindow();
+  return true;
+}
+
+// ==========================================
+// WINDOW LINES (CSV mode)
+// ==========================================
+// The frame's numbers as text, one line per field so that each fits
+// the TX buffer whole:
+//   WINDOW:count,field,min,max,mean,sd (field in SampleField order,
+//   wire units)
+// serviceWindowLines() prints one per call once there is room for it.
+// The window takes no new samples until the last line is out, then
+// restarts.
+
+#define WINDOW_LINE_MAX 41 // Longest line, "\r\n" included
+
+// Starts the report; nothing if one is already going out
+void startWindowLines() {
+  if (windowLineField == 0xFF) {
+    windowLineField = 0;
+  }
+}
+
+void serviceWindowLines() {
+  if (windowLineField == 0xFF ||
+      Serial.availableForWrite() < WINDOW_LINE_MAX) {
+    return;
+  }
+
+  const FieldStats &stats = windowStats[windowLineField];
+  Serial.print(F("WINDOW:"));
+  Serial.print(windowSamples);
+  Serial.print(',');
+  Serial.print(windowLineField);
+  Serial.print(',');
+  Serial.print(windowMin(stats));
+  Serial.print(',');
+  Serial.print(windowMax(stats));
+  Serial.print(',');
+  Serial.print(windowMean(stats));
+  Serial.print(',');
+  Serial.println(windowStdDev(stats));
+
+  if (++windowLineField == FIELD_COUNT) {
+    windowLineField = 0xFF;
+    resetWindow();
+  }
+}
+
+// ==========================================
+// HISTORY FRAMES
+// ==========================================
+// Payload: uint8 age of the first sample (0 = newest), uint8 samples
+// in the ring, then up to HISTORY_PER_FRAME samples, newest first, in
+// the keyframe layout without device and health (PackedSample's 13
+// bytes, with the keyframe's invalid markers).
+
+#define HISTORY_PER_FRAME 4
+#define HISTORY_PAYLOAD_SIZE(count) (2 + (count) * sizeof(PackedSample))
+
+static_assert(HISTORY_PAYLOAD_SIZE(HISTORY_PER_FRAME) <= FRAME_MAX_PAYLOAD,
+              "History frame too large");
+
+uint8_t historyDumpAge = 0xFF; // Next sample to send; 0xFF = no request
+
+// Bridge sent HISTORY
+void requestHistory() { historyDumpAge = 0; }
+
+// Send the next history frame if one is due and fits the TX buffer
+// (an empty ring still gets one frame, so the bridge hears back)
+void serviceHistory() {
+  if (historyDumpAge == 0xFF) {
+    return;
+  }
+
+  uint8_t count = historyCount - historyDumpAge;
+  if (count > HISTORY_PER_FRAME) {
+    count = HISTORY_PER_FRAME;
+  }
+  if (!frameRoom(HISTORY_PAYLOAD_SIZE(count))) {
+    return;
+  }
+
+  FrameWriter frame;
+  frameBegin(frame, FRAME_HISTORY);
+  frameU8(frame, historyDumpAge);
+  frameU8(frame, historyCount);
+  for (uint8_t i = 0; i < count; i++) {
+    QuantizedSample sample;
+    int16_t wire[WIRE_FIELD_COUNT];
+    historySample(historyDumpAge + i, sample);
+    toWireFields(sample, wire);
+    frameWireSample(frame, wire);
+  }
+  frameSend(frame);
+
+  historyDumpAge += count;
+  if (historyDumpAge >= historyCount) {
+    historyDumpAge = 0xFF;
+  }
+}
+
+#endif // HISTORY_H
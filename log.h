@@ -0,0 +1,154 @@
+/*
+ * Logging for Disaster Recon UAV
+ *
+ * Debug text is kept off the data path:
+ * - LOG_LEVEL (config.h) picks the levels that are compiled in; the
+ *   others expand to nothing, strings and arguments included
+ * - With LOG_FRAMES each message goes out as a FRAME_LOG frame:
+ *   the bridge skips it by frame type without parsing any text, and
+ *   values travel as binary instead of being formatted here
+ * - Without LOG_FRAMES messages are "[I TAG] text" lines for the
+ *   Serial Monitor (the bridge already ignores lines starting '[')
+ *
+ * Usage: LOG_WARN(LOG_TAG_SENSOR, F("DHT11: Temperature read error"));
+ *        LOG_INFO(LOG_TAG_IR, F("IR Code received: 0x"), LOG_HEX(code));
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include "config.h"
+#include "frame.h"
+#include <Arduino.h>
+
+// Levels (LOG_LEVEL keeps everything at or below it)
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Subsystem tags (also in telemetry_protocol.py)
+enum LogTag {
+  LOG_TAG_SYS,
+  LOG_TAG_IR,
+  LOG_TAG_SENSOR,
+  LOG_TAG_MOTOR,
+  LOG_TAG_STATE,
+  LOG_TAG_LINK,
+  LOG_TAG_COUNT
+};
+
+// Log frame payload:
+//   uint8  level<<4 | tag
+//   uint8  flags (LOG_HAS_VALUE, LOG_VALUE_HEX)
+//   int32  value (only with LOG_HAS_VALUE)
+//   char   text[] (rest of the payload, no terminator)
+#define LOG_HAS_VALUE 0x01
+#define LOG_VALUE_HEX 0x02
+
+// Wrap a value to print it in hex
+struct LogHex {
+  unsigned long value;
+};
+#define LOG_HEX(x) (LogHex{(unsigned long)(x)})
+
+// Until setup() ends a full TX buffer is waited out so boot messages
+// aren't lost; after that a message that doesn't fit is dropped
+bool logWaitForRoom = true;
+uint16_t logDropped = 0;
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+#if !LOG_FRAMES
+const char logTagNames[LOG_TAG_COUNT][7] PROGMEM = {
+    "SYS", "IR", "SENSOR", "MOTOR", "STATE", "LINK",
+};
+const char logLevelLetters[] PROGMEM = "-EWID";
+#endif
+
+void logWrite(uint8_t level, uint8_t tag, const __FlashStringHelper *message,
+              long value, uint8_t flags) {
+#if LOG_FRAMES
+  uint8_t header = 2 + ((flags & LOG_HAS_VALUE) ? 4 : 0);
+  size_t textLength = strlen_P((PGM_P)message);
+  if (textLength > (size_t)(FRAME_MAX_PAYLOAD - header)) {
+    textLength = FRAME_MAX_PAYLOAD - header;
+  }
+  if (!logWaitForRoom && !frameRoom(header + textLength)) {
+    if (logDropped < 0xFFFF) {
+      logDropped++;
+    }
+    return;
+  }
+
+  FrameWriter frame;
+  frameBegin(frame, FRAME_LOG);
+  frameU8(frame, (level << 4) | tag);
+  frameU8(frame, flags);
+  if (flags & LOG_HAS_VALUE) {
+    frameU32(frame, (uint32_t)value);
+  }
+  PGM_P text = (PGM_P)message;
+  for (size_t i = 0; i < textLength; i++) {
+    frameU8(frame, pgm_read_byte(text + i));
+  }
+  frameSend(frame);
+#else
+  Serial.print('[');
+  Serial.print((char)pgm_read_byte(&logLevelLetters[level]));
+  Serial.print(' ');
+  Serial.print((const __FlashStringHelper *)logTagNames[tag]);
+  Serial.print(F("] "));
+  Serial.print(message);
+  if (flags & LOG_VALUE_HEX) {
+    Serial.print((unsigned long)value, HEX);
+  } else if (flags & LOG_HAS_VALUE) {
+    Serial.print(value);
+  }
+  Serial.println();
+#endif
+}
+
+void logEvent(uint8_t level, uint8_t tag, const __FlashStringHelper *message) {
+  logWrite(level, tag, message, 0, 0);
+}
+
+void logEvent(uint8_t level, uint8_t tag, const __FlashStringHelper *message,
+              long value) {
+  logWrite(level, tag, message, value, LOG_HAS_VALUE);
+}
+
+void logEvent(uint8_t level, uint8_t tag, const __FlashStringHelper *message,
+              LogHex value) {
+  logWrite(level, tag, message, (long)value.value,
+           LOG_HAS_VALUE | LOG_VALUE_HEX);
+}
+
+#endif // LOG_LEVEL > LOG_LEVEL_NONE
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logEvent(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logEvent(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logEvent(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logEvent(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#endif // LOG_H
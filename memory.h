@@ -0,0 +1,70 @@
+/*
+ * Memory Accounting for Disaster Recon UAV
+ *
+ * The Uno has 2 KB of SRAM. Globals sit at the bottom, the heap (if a
+ * library mallocs) grows up from them and the stack grows down from
+ * RAMEND; nothing stops the two meeting. This measures the gap:
+ * - paintStack() fills the gap with a canary byte once, at boot
+ * - freeRam() is the gap right now
+ * - minFreeRam() is the smallest it has been: the canary bytes the
+ *   stack (interrupts included) hasn't overwritten yet
+ *
+ * The numbers go to the bridge as the STATS_MEMORY page (profile.h).
+ * size_report.py splits the static part per module at build time.
+ */
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <Arduino.h>
+
+#define STACK_CANARY 0xC5
+#define STACK_PAINT_MARGIN 32 // Bytes below SP left alone (our own frame)
+
+#if defined(__AVR__)
+
+extern char __data_start; // Start of .data (linker)
+extern char __heap_start; // End of .bss (linker)
+extern char *__brkval;    // Heap top, 0 until the first malloc()
+
+// First byte above the heap
+char *heapEnd() { return __brkval ? __brkval : &__heap_start; }
+
+uint16_t ramSize() { return RAMEND - RAMSTART + 1; }
+
+// .data + .bss
+uint16_t staticRam() { return &__heap_start - &__data_start; }
+
+uint16_t heapUsed() { return heapEnd() - &__heap_start; }
+
+uint16_t freeRam() { return (char *)SP - heapEnd(); }
+
+// Call first thing in setup()
+void paintStack() {
+  char *limit = (char *)SP - STACK_PAINT_MARGIN;
+  for (char *p = heapEnd(); p < limit; p++) {
+    *p = STACK_CANARY;
+  }
+}
+
+uint16_t minFreeRam() {
+  char *p = heapEnd();
+  while (p < (char *)SP && *(uint8_t *)p == STACK_CANARY) {
+    p++;
+  }
+  return p - heapEnd();
+}
+
+#else
+
+// Host build: no fixed memory map to measure
+uint16_t ramSize() { return 0; }
+uint16_t staticRam() { return 0; }
+uint16_t heapUsed() { return 0; }
+uint16_t freeRam() { return 0; }
+void paintStack() {}
+uint16_t minFreeRam() { return 0; }
+
+#endif // __AVR__
+
+#endif // MEMORY_H
@@ -2,142 +2,280 @@
  * Motor Control & State Machine for Disaster Recon UAV
  *
  * Handles:
- * - DC Motor control (ON/OFF)
- * - UAV state management
- * - State transitions
+ * - DC Motor control (target speed, soft-start ramp, direction)
+ * - UAV states: a PROGMEM transition table, with entry/exit actions
+ *   run from a scheduler task instead of inside the transition
  *
  * Motor Driver: L293D H-Bridge
  * Wiring Instructions:
  * - Connect motor to OUT1/OUT2 on L293D
  * - Connect MOTOR_ENABLE (D3) to Enable1 on L293D
- * - Connect MOTOR_IN1 (D7) to IN1 on L293D
- * - Connect MOTOR_IN2 (D8) to IN2 on L293D
+ * - Connect MOTOR_IN1 (D4) to IN1 on L293D
+ * - Connect MOTOR_IN2 (D5) to IN2 on L293D
  */
 
 #ifndef MOTOR_CONTROL_H
 #define MOTOR_CONTROL_H
 
 #include "config.h"  // For motor pins and state constants
+#include "log.h"
 #include "sensors.h" // For SensorData type
 
 // ==========================================
 // MOTOR CONTROL
 // ==========================================
+// Callers only set a target speed and direction; the 1 ms tick
+// (motorTick(), driven by the pattern timer in actuators.h) slews the
+// output towards it one step every MOTOR_RAMP_MS, so the motor never
+// jumps from 0 to full current. A direction change ramps down to a
+// stop, flips IN1/IN2 and ramps back up.
+//
+// D3 is OC2B, but IRremote owns Timer2, so analogWrite() can't make a
+// PWM there. The tick drives the enable pin with first-order
+// sigma-delta modulation instead: the speed is added to an 8-bit
+// accumulator each tick and the pin is high on the ticks it carries
+// out, so the duty cycle averages speed/255 (the motor's inertia
+// smooths the ~1 kHz pulses).
+
+enum MotorDirection { MOTOR_FORWARD, MOTOR_REVERSE };
+
+// Closed-loop hook: given the state's base speed and each new fused
+// attitude (0.1 °), return the speed to run at. NULL = open loop.
+typedef uint8_t (*MotorLoop)(uint8_t baseSpeed, tenths_t pitch,
+                             tenths_t roll);
+
+volatile uint8_t motorSpeed = 0;  // Output now (written by the tick)
+volatile uint8_t motorTarget = 0; // Where the ramp is heading
+volatile uint8_t motorDirection = MOTOR_FORWARD; // Wanted direction
+uint8_t motorBaseSpeed = 0;       // Set by the state, before the hook
+MotorLoop motorLoop = NULL;
+
+// Tick-only state
+uint8_t motorAccumulator = 0;
+uint8_t motorRampMs = 0;
+uint8_t motorPinDirection = MOTOR_FORWARD; // What IN1/IN2 are set to
+bool motorEnableHigh = false;
+
+void writeMotorDirection(uint8_t direction) {
+  digitalWrite(MOTOR_IN1, direction == MOTOR_FORWARD ? HIGH : LOW);
+  digitalWrite(MOTOR_IN2, direction == MOTOR_FORWARD ? LOW : HIGH);
+  motorPinDirection = direction;
+}
+
+// One millisecond of ramp and modulation (ISR context on AVR)
+void motorTick() {
+  // A direction change first runs the speed down to zero
+  uint8_t target = motorDirection == motorPinDirection ? motorTarget : 0;
+  if (motorSpeed == 0 && motorDirection != motorPinDirection) {
+    writeMotorDirection(motorDirection);
+  }
+
+  if (motorSpeed != target && ++motorRampMs >= MOTOR_RAMP_MS) {
+    motorRampMs = 0;
+    motorSpeed += motorSpeed < target ? 1 : -1;
+  }
+
+  bool high;
+  if (motorSpeed == 255) {
+    high = true;
+  } else {
+    uint8_t before = motorAccumulator;
+    motorAccumulator += motorSpeed;
+    high = motorAccumulator < before; // Carry out
+  }
+  if (high != motorEnableHigh) {
+    digitalWrite(MOTOR_ENABLE, high ? HIGH : LOW);
+    motorEnableHigh = high;
+  }
+}
 
 void initializeMotor() {
   pinMode(MOTOR_IN1, OUTPUT);
   pinMode(MOTOR_IN2, OUTPUT);
   pinMode(MOTOR_ENABLE, OUTPUT);
 
-  // Start with motor OFF
-  analogWrite(MOTOR_ENABLE, 0); // Speed = 0
-  digitalWrite(MOTOR_IN1, LOW);
-  digitalWrite(MOTOR_IN2, LOW);
+  // Start with motor OFF, set for forward
+  digitalWrite(MOTOR_ENABLE, LOW);
+  writeMotorDirection(MOTOR_FORWARD);
 }
 
-void motorOn() {
-  digitalWrite(MOTOR_IN1, HIGH);  // Forward direction
-  digitalWrite(MOTOR_IN2, LOW);   // Forward direction
-  analogWrite(MOTOR_ENABLE, 255); // Full speed (PWM)
-  Serial.println(F("Motor: ON (Full Speed)"));
+// Ramp to a new speed; setting the current target again changes nothing
+void setMotorTarget(uint8_t speed) { motorTarget = speed; }
+
+void setMotorDirection(uint8_t direction) { motorDirection = direction; }
+
+// Speed for the current state; the closed-loop hook may trim it
+void setMotorBaseSpeed(uint8_t speed) {
+  if (speed == motorBaseSpeed) {
+    return; // Same state speed again: let the ramp carry on
+  }
+  motorBaseSpeed = speed;
+  setMotorTarget(speed);
+  LOG_INFO(LOG_TAG_MOTOR, F("Target speed: "), (long)speed);
 }
 
-void motorOff() {
-  analogWrite(MOTOR_ENABLE, 0); // Speed = 0 (stop)
-  digitalWrite(MOTOR_IN1, LOW);
-  digitalWrite(MOTOR_IN2, LOW);
-  Serial.println(F("Motor: OFF"));
+void setMotorLoop(MotorLoop loop) { motorLoop = loop; }
+
+// Feed a fused attitude to the closed-loop hook (from taskIMU)
+void motorAttitude(tenths_t pitch, tenths_t roll) {
+  if (motorLoop != NULL && motorBaseSpeed != 0) {
+    setMotorTarget(motorLoop(motorBaseSpeed, pitch, roll));
+  }
 }
 
+uint8_t getMotorSpeed() { return motorSpeed; }
+
 // ==========================================
 // STATE MACHINE
 // ==========================================
+// Transitions are a lookup in a PROGMEM table of [state][event]:
+// stateEvent() changes currentState on the spot and does nothing else.
+// What a state does on the way in and out (motor speed, LED, LCD,
+// buzzer) is in stateActions[], run later by runStateActions() from
+// its own task. If the state changes twice before that task runs, only
+// the first exit and the last entry are run.
+
+enum StateEvent : uint8_t {
+  EVENT_POWER_ON,     // IR ON
+  EVENT_POWER_OFF,    // IR OFF
+  EVENT_WARMED_UP,    // IDLE warm-up over (taskIR)
+  EVENT_HAZARD,       // A RULE_RAISES_ALERT rule holds (taskAlerts)
+  EVENT_ALL_CLEAR,    // None of them do
+  EVENT_SENSOR_FAULT, // A critical sensor is down (health.h), no hazard showing
+  EVENT_COUNT
+};
+
+#define STATE_STAY 0xFF // Transition table: event changes nothing
+
+// Next state, rows in UAVState order, columns in StateEvent order
+const uint8_t stateTransitions[STATE_COUNT][EVENT_COUNT] PROGMEM = {
+    //            ON          OFF        WARMED_UP     HAZARD       ALL_CLEAR     FAULT
+    /* OFF    */ {STATE_IDLE, STATE_STAY, STATE_STAY,   STATE_STAY,  STATE_STAY,   STATE_STAY},
+    /* IDLE   */ {STATE_STAY, STATE_OFF,  STATE_ACTIVE, STATE_STAY,  STATE_STAY,   STATE_STAY},
+    /* ACTIVE */ {STATE_STAY, STATE_OFF,  STATE_STAY,   STATE_ALERT, STATE_STAY,   STATE_ERROR},
+    /* ALERT  */ {STATE_STAY, STATE_OFF,  STATE_STAY,   STATE_STAY,  STATE_ACTIVE, STATE_ERROR},
+    /* ERROR  */ {STATE_STAY, STATE_OFF,  STATE_STAY,   STATE_ALERT, STATE_ACTIVE, STATE_STAY},
+};
+
+typedef void (*StateAction)();
+
+struct StateActions {
+  StateAction enter; // NULL = nothing to do
+  StateAction exit;
+};
 
-int currentState = STATE_OFF;
-int previousState = STATE_OFF;
-
-int getCurrentState() { return currentState; }
-
-void setState(int newState) {
-  if (newState != currentState) {
-    previousState = currentState;
-    currentState = newState;
-
-    // Beep on state change
-    beepStateChange();
-
-    // Print state change to Serial
-    Serial.print(F("State changed: "));
-    Serial.print(previousState);
-    Serial.print(F(" -> "));
-    Serial.println(currentState);
-
-    // Handle state-specific actions
-    switch (currentState) {
-    case STATE_OFF:
-      motorOff();
-      rgbOff();
-      displayOff();
-      break;
-
-    case STATE_IDLE:
-      motorOn();
-      rgbPurple();
-      lcd.backlight(); // Ensure backlight is on
-      lcd.clear();
-      lcd.print(F("UAV ACTIVE"));
-      lcd.setCursor(0, 1);
-      lcd.print(F("Warming up..."));
-      break;
-
-    case STATE_ACTIVE:
-      motorOn();
-      rgbGreen();
-      lcd.backlight(); // Ensure backlight is on
-      break;
-
-    case STATE_ALERT:
-      motorOn();
-      rgbRed();
-      displayAlert();
-      beepHazard(); // 3 beeps
-      break;
-
-    case STATE_ERROR:
-      motorOff();
-      rgbYellow();
-      displayError();
-      break;
-    }
+void enterOff() {
+  setMotorBaseSpeed(0);
+  rgbOff();
+  displayOff();
+}
+
+void exitOff() {
+  screen.backlight(); // Wake the LCD
+}
+
+void enterIdle() {
+  setMotorBaseSpeed(MOTOR_SPEED_IDLE);
+  rgbPurple();
+  screen.clear();
+  screen.print(F("UAV ACTIVE"));
+  screen.setCursor(0, 1);
+  screen.print(F("Warming up..."));
+}
+
+void enterActive() {
+  setMotorBaseSpeed(MOTOR_SPEED_ACTIVE);
+  rgbGreen();
+}
+
+void enterAlert() {
+  setMotorBaseSpeed(MOTOR_SPEED_ACTIVE);
+  rgbRed();
+  displayAlert();
+  beepHazard(); // 3 beeps
+}
+
+void enterError() {
+  setMotorBaseSpeed(0);
+  rgbYellow();
+  displayError();
+}
+
+const StateActions stateActions[STATE_COUNT] PROGMEM = {
+    {enterOff, exitOff}, // OFF
+    {enterIdle, NULL},   // IDLE
+    {enterActive, NULL}, // ACTIVE
+    {enterAlert, NULL},  // ALERT
+    {enterError, NULL},  // ERROR
+};
+
+uint8_t currentState = STATE_OFF;
+uint8_t previousState = STATE_OFF;
+uint8_t pendingExit = STATE_STAY; // State whose actions haven't run yet
+
+uint8_t getCurrentState() { return currentState; }
+
+// Move to a state now; its actions run from the next runStateActions()
+void setState(uint8_t newState) {
+  if (newState == currentState) {
+    return;
+  }
+  if (pendingExit == STATE_STAY) {
+    pendingExit = currentState;
   }
+  previousState = currentState;
+  currentState = newState;
+
+  // Log the state change (the previous state is in the last entry)
+  LOG_INFO(LOG_TAG_STATE, F("State changed to "), (long)currentState);
 }
 
-// Update state based on sensor readings
-void updateState(SensorData data) {
-  // Only update state if UAV is ON (not in OFF state)
-  if (currentState == STATE_OFF) {
-    return; // Don't auto-transition from OFF
+// Returns true if the event changed the state
+bool stateEvent(uint8_t event) {
+  uint8_t next = pgm_read_byte(&stateTransitions[currentState][event]);
+  if (next == STATE_STAY) {
+    return false;
   }
+  setState(next);
+  return true;
+}
 
-  // DISABLED: Error checking - motor wiring issue
-  // if (!data.valid) {
-  //   setState(STATE_ERROR);
-  //   return;
-  // }
+bool stateActionsPending() { return pendingExit != STATE_STAY; }
 
-  // Check for hazards
-  if (isHazardousGas(data.gasLevel)) {
-    setState(STATE_ALERT);
+// Exit actions of the state left, then entry actions of the state now
+void runStateActions() {
+  uint8_t left = pendingExit;
+  if (left == STATE_STAY) {
     return;
   }
+  pendingExit = STATE_STAY;
+  if (left == currentState) {
+    return; // Went there and back before the actions ran
+  }
+
+  beepStateChange();
+  StateAction onExit = (StateAction)pgm_read_ptr(&stateActions[left].exit);
+  if (onExit != NULL) {
+    onExit();
+  }
+  StateAction onEnter =
+      (StateAction)pgm_read_ptr(&stateActions[currentState].enter);
+  if (onEnter != NULL) {
+    onEnter();
+  }
+}
 
-  // Normal operation
-  if (currentState == STATE_IDLE || currentState == STATE_ACTIVE ||
-      currentState == STATE_ALERT) {
-    // Return to ACTIVE if no hazards
-    if (currentState != STATE_ACTIVE) {
-      setState(STATE_ACTIVE);
-    }
+// Follow the hazard rules and sensor health (called after each
+// evaluateHazards()). A hazard the working sensors see wins over a
+// fault elsewhere; ERROR clears by itself once the critical sensors
+// are back. A climate or ranging fault alone keeps the UAV flying.
+void updateState(bool hazard) {
+  if (hazard) {
+    stateEvent(EVENT_HAZARD);
+  } else if (criticalSensorDown()) {
+    stateEvent(EVENT_SENSOR_FAULT);
+  } else {
+    stateEvent(EVENT_ALL_CLEAR);
   }
 }
 
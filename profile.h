@@ -0,0 +1,224 @@
+/*
+ * Loop Profiler for Disaster Recon UAV
+ *
+ * Lightweight timing so performance changes can be measured:
+ * - PROFILE_SCOPE(section) times the rest of a block with micros()
+ *   and keeps count/min/max/total per section
+ * - profileLoop() buckets the time between loop() passes into a
+ *   log2 histogram (bucket b = periods of b bits, i.e. < 2^b us)
+ * - The SRAM budget from memory.h, free space and its low-water mark
+ * - Sensor health, I2C recoveries and watchdog timeouts (health.h)
+ * - Deadline misses per scheduler task (scheduler.h)
+ *
+ * The bridge asks for the numbers with a STATS line; they come back
+ * as a few FRAME_STATS frames and the counters restart. Everything
+ * compiles away with PROFILE_ENABLED 0.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "config.h"
+#include "frame.h"
+#include "health.h"
+#include "memory.h"
+#include "scheduler.h"
+#include <Arduino.h>
+
+// Timed sections (names in telemetry_protocol.py)
+enum ProfileSection {
+  PROF_IR,      // handleIRRemote()
+  PROF_DHT,     // Temperature + humidity read
+  PROF_GAS,     // MQ-2 read
+  PROF_RANGING, // updateRanging()
+  PROF_IMU,     // updateMPU()
+  PROF_ALERTS,  // Hazard rule pass
+  PROF_LCD,     // LCD flush over I2C
+  PROF_UPLINK,  // sendDataToSerial()
+  PROF_COUNT
+};
+
+#define LOOP_HIST_BUCKETS 20 // Last bucket: periods >= 2^18 us (262 ms)
+
+// Stats payload: uint8 page, then
+//   STATS_SECTIONS: uint8 first section, per section
+//                   uint16 count, min, max, avg (us, saturated)
+//   STATS_LOOP:     uint16 bucket counts (saturated)
+//   STATS_MEMORY:   uint16 RAM size, static (.data + .bss), heap,
+//                   free now, least free since boot (bytes)
+//   STATS_HEALTH:   per SensorId uint16 reads, failures; then uint8
+//                   healthFlags, uint16 I2C recoveries, uint16 IMU
+//                   overflows, uint8 watchdog timeouts, uint8 task of
+//                   the last one (since boot, not restarted by a request)
+//   STATS_TASKS:    uint16 deadline misses per task (TaskId order)
+#define STATS_SECTIONS 0
+#define STATS_LOOP 1
+#define STATS_MEMORY 2
+#define STATS_HEALTH 3
+#define STATS_TASKS 4
+#define STATS_SECTIONS_PER_FRAME 6
+
+#if PROFILE_ENABLED
+
+struct SectionStats {
+  uint16_t count;
+  uint16_t minUs;
+  uint16_t maxUs;
+  uint32_t totalUs;
+};
+
+SectionStats profileStats[PROF_COUNT];
+uint16_t loopHistogram[LOOP_HIST_BUCKETS];
+unsigned long lastLoopStart = 0;
+uint8_t statsPage = 0xFF; // Next page to send; 0xFF = no request
+
+void resetProfile() {
+  memset(profileStats, 0, sizeof(profileStats));
+  memset(loopHistogram, 0, sizeof(loopHistogram));
+}
+
+void profileRecord(uint8_t section, unsigned long elapsed) {
+  SectionStats &stats = profileStats[section];
+  uint16_t us = elapsed > 0xFFFF ? 0xFFFF : elapsed;
+  if (stats.count == 0 || us < stats.minUs) {
+    stats.minUs = us;
+  }
+  if (us > stats.maxUs) {
+    stats.maxUs = us;
+  }
+  if (stats.count < 0xFFFF) {
+    stats.count++;
+    stats.totalUs += us;
+  }
+}
+
+// Times its enclosing scope
+class ProfileScope {
+public:
+  explicit ProfileScope(uint8_t section) : section(section), start(micros()) {}
+  ~ProfileScope() { profileRecord(section, micros() - start); }
+
+private:
+  uint8_t section;
+  unsigned long start;
+};
+
+#define PROFILE_SCOPE(section) ProfileScope profileScope_(section)
+
+// Call at the top of loop()
+void profileLoop() {
+  unsigned long now = micros();
+  unsigned long period = now - lastLoopStart;
+  lastLoopStart = now;
+
+  uint8_t bucket = 0;
+  while (period && bucket < LOOP_HIST_BUCKETS - 1) {
+    period >>= 1;
+    bucket++;
+  }
+  if (loopHistogram[bucket] < 0xFFFF) {
+    loopHistogram[bucket]++;
+  }
+}
+
+// Bridge sent STATS
+void requestStats() { statsPage = 0; }
+
+// Send the next stats page if one is due and fits the TX buffer
+void serviceStats(Task *tasks, uint8_t taskCount) {
+  const uint8_t sectionPages =
+      (PROF_COUNT + STATS_SECTIONS_PER_FRAME - 1) / STATS_SECTIONS_PER_FRAME;
+  const uint8_t lastPage = sectionPages + 3; // Loop, memory, health, tasks
+  if (statsPage > lastPage) {
+    return;
+  }
+
+  FrameWriter frame;
+  if (statsPage < sectionPages) {
+    uint8_t first = statsPage * STATS_SECTIONS_PER_FRAME;
+    uint8_t count = PROF_COUNT - first;
+    if (count > STATS_SECTIONS_PER_FRAME) {
+      count = STATS_SECTIONS_PER_FRAME;
+    }
+    if (!frameRoom(2 + count * 8)) {
+      return;
+    }
+
+    frameBegin(frame, FRAME_STATS);
+    frameU8(frame, STATS_SECTIONS);
+    frameU8(frame, first);
+    for (uint8_t i = first; i < first + count; i++) {
+      const SectionStats &stats = profileStats[i];
+      frameU16(frame, stats.count);
+      frameU16(frame, stats.minUs);
+      frameU16(frame, stats.maxUs);
+      frameU16(frame, stats.count ? stats.totalUs / stats.count : 0);
+    }
+  } else if (statsPage == sectionPages) {
+    if (!frameRoom(1 + LOOP_HIST_BUCKETS * 2)) {
+      return;
+    }
+
+    frameBegin(frame, FRAME_STATS);
+    frameU8(frame, STATS_LOOP);
+    for (uint8_t i = 0; i < LOOP_HIST_BUCKETS; i++) {
+      frameU16(frame, loopHistogram[i]);
+    }
+  } else if (statsPage == sectionPages + 1) {
+    if (!frameRoom(1 + 5 * 2)) {
+      return;
+    }
+
+    frameBegin(frame, FRAME_STATS);
+    frameU8(frame, STATS_MEMORY);
+    frameU16(frame, ramSize());
+    frameU16(frame, staticRam());
+    frameU16(frame, heapUsed());
+    frameU16(frame, freeRam());
+    frameU16(frame, minFreeRam());
+  } else if (statsPage == sectionPages + 2) {
+    if (!frameRoom(1 + SENSOR_COUNT * 4 + 7)) {
+      return;
+    }
+
+    frameBegin(frame, FRAME_STATS);
+    frameU8(frame, STATS_HEALTH);
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+      frameU16(frame, sensorHealth[i].reads);
+      frameU16(frame, sensorHealth[i].failures);
+    }
+    frameU8(frame, healthFlags);
+    frameU16(frame, i2cRecoveries);
+    frameU16(frame, imuOverflows);
+    frameU8(frame, watchdogRecord.bites);
+    frameU8(frame, watchdogRecord.lastTask);
+  } else {
+    if (!frameRoom(1 + taskCount * 2)) {
+      return;
+    }
+
+    frameBegin(frame, FRAME_STATS);
+    frameU8(frame, STATS_TASKS);
+    for (uint8_t i = 0; i < taskCount; i++) {
+      frameU16(frame, tasks[i].missed);
+      tasks[i].missed = 0; // Restarts like the section timings
+    }
+  }
+  frameSend(frame);
+
+  if (++statsPage > lastPage) {
+    statsPage = 0xFF;
+    resetProfile(); // Next request covers the time since this one
+  }
+}
+
+#else
+
+#define PROFILE_SCOPE(section) ((void)0)
+void profileLoop() {}
+void requestStats() {}
+void serviceStats(Task *tasks, uint8_t taskCount) {}
+
+#endif // PROFILE_ENABLED
+
+#endif // PROFILE_H
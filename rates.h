@@ -0,0 +1,105 @@
+/*
+ * Adaptive Sampling Rates for Disaster Recon UAV
+ *
+ * Each sensor is read at one of three rates (RATE_* table in config.h),
+ * picked from the hazard rules in alerts.h:
+ * - ALERT: one of the sensor's rules holds, or the UAV is in STATE_ALERT
+ * - NEAR:  a reading is within RATE_NEAR_FACTOR hysteresis widths of
+ *          a rule's limit
+ * - CALM:  everything else; fewer ADC reads, pings and I2C transfers
+ *
+ * updateRateLevels() works on a quantized sample, so the near zone is
+ * checked with the same comparators and units as the rules themselves.
+ * The sketch copies sampleInterval() into the task periods.
+ */
+
+#ifndef RATES_H
+#define RATES_H
+
+#include "alerts.h" // For hazardRules, hazardActive and ruleHolds()
+#include "config.h"
+#include "telemetry.h" // For QuantizedSample and SampleField
+#include <Arduino.h>
+
+enum RateSensor {
+  RATE_SENSOR_GAS,
+  RATE_SENSOR_RANGING,
+  RATE_SENSOR_IMU,
+  RATE_SENSOR_CLIMATE,
+  RATE_SENSOR_COUNT
+};
+
+enum RateLevel { RATE_CALM, RATE_NEAR, RATE_ALERT, RATE_LEVEL_COUNT };
+
+// ms between reads, rows in RateSensor order
+const uint16_t sampleRates[RATE_SENSOR_COUNT][RATE_LEVEL_COUNT] PROGMEM = {
+    {RATE_GAS},
+    {RATE_RANGING},
+    {RATE_IMU},
+    {RATE_CLIMATE},
+};
+
+#define RATE_CALM_MS(rates) RATE_FIRST(rates)
+#define RATE_FIRST(calm, near, alert) (calm)
+
+// The slowest FIFO drain must still fit in the IMU ring (sensors.h)
+static_assert((uint32_t)RATE_CALM_MS(RATE_IMU) * IMU_RATE_HZ / 1000 <=
+                  IMU_RING_SIZE,
+              "RATE_IMU drains more samples than IMU_RING_SIZE holds");
+
+uint8_t rateLevels[RATE_SENSOR_COUNT]; // RateLevel, all CALM at boot
+
+// Sensor that measures a sample field
+uint8_t rateSensorOf(uint8_t field) {
+  switch (field) {
+  case FIELD_GAS:
+    return RATE_SENSOR_GAS;
+  case FIELD_DISTANCE:
+    return RATE_SENSOR_RANGING;
+  case FIELD_PITCH:
+  case FIELD_ROLL:
+  case FIELD_YAW:
+    return RATE_SENSOR_IMU;
+  default:
+    return RATE_SENSOR_CLIMATE;
+  }
+}
+
+uint16_t sampleInterval(uint8_t sensor) {
+  return pgm_read_word(&sampleRates[sensor][rateLevels[sensor]]);
+}
+
+// Re-pick every sensor's level; returns true if any changed
+bool updateRateLevels(const QuantizedSample &sample, int state) {
+  uint8_t levels[RATE_SENSOR_COUNT] = {RATE_CALM};
+
+  for (uint8_t i = 0; i < HAZARD_RULE_COUNT; i++) {
+    HazardRule rule;
+    memcpy_P(&rule, &hazardRules[i], sizeof(rule));
+
+    uint8_t sensor = rateSensorOf(rule.field);
+    int16_t value = sample.field[rule.field];
+    uint8_t level = RATE_CALM;
+    if (hazardActive & (1 << i)) {
+      level = RATE_ALERT;
+    } else if (value != SAMPLE_INVALID &&
+               ruleHolds(rule, value, rule.hysteresis * RATE_NEAR_FACTOR)) {
+      level = RATE_NEAR;
+    }
+    if (level > levels[sensor]) {
+      levels[sensor] = level;
+    }
+  }
+
+  bool changed = false;
+  for (uint8_t sensor = 0; sensor < RATE_SENSOR_COUNT; sensor++) {
+    uint8_t level = state == STATE_ALERT ? (uint8_t)RATE_ALERT : levels[sensor];
+    if (level != rateLevels[sensor]) {
+      rateLevels[sensor] = level;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+#endif // RATES_H
@@ -0,0 +1,105 @@
+/*
+ * IR Remote Commands for Disaster Recon UAV
+ *
+ * The IRremote receive interrupt hands each decoded frame to
+ * onIRFrame(), which pushes its code into a small queue; taskIR()
+ * pops the codes and looks them up in a PROGMEM table of commands:
+ * - Presses made while the loop is busy wait in the queue instead of
+ *   being overwritten by the next frame (IR_QUEUE_SIZE in config.h)
+ * - Repeat frames (button held down) never reach the queue
+ * - Codes missing from the table are logged and ignored
+ *
+ * The queue is single-producer/single-consumer and needs no locking:
+ * only the ISR moves the head, only the task moves the tail, each is
+ * one byte, and a slot is filled before the head that publishes it.
+ */
+
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#include "config.h" // For IR_PIN, button codes and IR_QUEUE_SIZE
+#include <IRremote.hpp>
+
+#if IR_QUEUE_SIZE > 128 || (IR_QUEUE_SIZE & (IR_QUEUE_SIZE - 1)) != 0
+#error "IR_QUEUE_SIZE must be a power of two up to 128"
+#endif
+
+enum RemoteCommand : uint8_t {
+  CMD_NONE, // Code not in the table
+  CMD_POWER_ON,
+  CMD_POWER_OFF,
+};
+
+struct RemoteKey {
+  uint32_t code;   // decodedRawData, as IR_Code_Scanner.ino shows it
+  uint8_t command; // RemoteCommand
+};
+
+// Add a row here to give another button a command
+const RemoteKey remoteKeys[] PROGMEM = {
+    {IR_BUTTON_ON, CMD_POWER_ON},
+    {IR_BUTTON_OFF, CMD_POWER_OFF},
+};
+
+#define REMOTE_KEY_COUNT (sizeof(remoteKeys) / sizeof(remoteKeys[0]))
+
+// ==========================================
+// CODE QUEUE (receive ISR -> taskIR)
+// ==========================================
+// Head and tail run freely and wrap at 256; head - tail is the fill.
+
+volatile uint32_t irQueue[IR_QUEUE_SIZE];
+volatile uint8_t irQueueHead = 0;    // Written by the ISR only
+volatile uint8_t irQueueTail = 0;    // Written by the task only
+volatile uint8_t irQueueDropped = 0; // Presses lost to a full queue
+
+// Receive-complete callback, runs in the IRremote interrupt
+void onIRFrame() {
+  if (IrReceiver.decode()) {
+    uint32_t code = IrReceiver.decodedIRData.decodedRawData;
+    bool repeat = IrReceiver.decodedIRData.flags & IRDATA_FLAGS_IS_REPEAT;
+
+    // Repeats come as flagged frames or as a bare 0x0 code
+    if (code != 0x0 && !repeat) {
+      uint8_t head = irQueueHead;
+      if ((uint8_t)(head - irQueueTail) < IR_QUEUE_SIZE) {
+        irQueue[head & (IR_QUEUE_SIZE - 1)] = code;
+        irQueueHead = head + 1; // Publish after the slot is written
+      } else if (irQueueDropped < 0xFF) {
+        irQueueDropped++;
+      }
+    }
+  }
+  IrReceiver.resume(); // Enable receiving of the next value
+}
+
+// Take the oldest queued code; false if there is none
+bool popIRCode(uint32_t &code) {
+  uint8_t tail = irQueueTail;
+  if (tail == irQueueHead) {
+    return false;
+  }
+  code = irQueue[tail & (IR_QUEUE_SIZE - 1)];
+  irQueueTail = tail + 1; // Hand the slot back after it's read
+  return true;
+}
+
+// ==========================================
+// BUTTON MAPPING
+// ==========================================
+
+uint8_t lookupRemoteCommand(uint32_t code) {
+  for (uint8_t i = 0; i < REMOTE_KEY_COUNT; i++) {
+    if (pgm_read_dword(&remoteKeys[i].code) == code) {
+      return pgm_read_byte(&remoteKeys[i].command);
+    }
+  }
+  return CMD_NONE;
+}
+
+void initializeRemote() {
+  IrReceiver.begin(IR_PIN, ENABLE_LED_FEEDBACK); // Start IR receiver
+  IrReceiver.registerReceiveCompleteCallback(onIRFrame);
+}
+
+#endif // REMOTE_H
@@ -0,0 +1,68 @@
+/*
+ * Cooperative Task Scheduler for Disaster Recon UAV
+ *
+ * Replaces the delay()-driven loop with a fixed table of tasks:
+ * - Each task has a period (how often it runs) and a deadline
+ *   (how late it may start before it counts as a miss)
+ * - Tasks must never block; long actions are split into steps
+ *   and resumed on the next call
+ *
+ * loop() just calls runTasks() as fast as it can. Each pass that
+ * returns kicks the watchdog (health.h); one that hangs gets the
+ * board reset, and the task it hung in reported after the reboot.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "health.h" // For the watchdog
+#include <Arduino.h>
+
+typedef void (*TaskFunction)();
+
+struct Task {
+  TaskFunction run;      // Task body (must return quickly)
+  uint16_t periodMs;     // 0 = run on every loop pass
+  uint16_t deadlineMs;   // Allowed start lateness before counting a miss
+  unsigned long lastRun; // millis() of the last start
+  uint16_t missed;       // Number of late starts
+};
+
+// ==========================================
+// TASK DISPATCH
+// ==========================================
+
+// Run every task that is due, in table order
+void runTasks(Task *tasks, uint8_t taskCount) {
+  for (uint8_t i = 0; i < taskCount; i++) {
+    Task &task = tasks[i];
+    unsigned long now = millis();
+    unsigned long elapsed = now - task.lastRun;
+
+    if (elapsed < task.periodMs) {
+      continue; // Not due yet
+    }
+
+    // Count a miss if we started later than period + deadline (the
+    // first run after boot waits on setup(), not on other tasks)
+    if (task.periodMs > 0 && task.lastRun != 0 &&
+        elapsed > (unsigned long)task.periodMs + task.deadlineMs &&
+        task.missed < 0xFFFF) {
+      task.missed++;
+    }
+
+    task.lastRun = now;
+    watchdogTask = i; // Blamed if the watchdog fires now
+    task.run();
+  }
+  watchdogTask = WATCHDOG_NO_TASK;
+  kickWatchdog();
+}
+
+// Make a task due on the next pass (e.g. right after a state change)
+void triggerTask(Task &task) { task.lastRun = millis() - task.periodMs; }
+
+// Push a task's next run a full period into the future
+void deferTask(Task &task) { task.lastRun = millis(); }
+
+#endif // SCHEDULER_H
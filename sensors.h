@@ -5,13 +5,21 @@
  * - DHT11 (Temperature & Humidity)
  * - MQ-2 (Gas/Smoke)
  * - Ultrasonic (Distance)
- * - MPU6050 (Pitch, Roll, Yaw) - Using Adafruit library
+ * - MPU6050 (Pitch, Roll, Yaw) - Adafruit library setup, fused raw reads
+ *
+ * Readings are kept in fixed point (see fixed.h); float only appears
+ * where the DHT library hands one back. Each read is reported to
+ * health.h, which holds back the retries of a sensor that is down.
  */
 
 #ifndef SENSORS_H
 #define SENSORS_H
 
 #include "config.h" // For sensor pins and thresholds
+#include "fixed.h"
+#include "health.h"
+#include "log.h"
+#include "profile.h"
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
 #include <DHT.h>
@@ -21,18 +29,24 @@
 DHT dht(DHT_PIN, DHTTYPE);
 Adafruit_MPU6050 mpu; // Adafruit MPU6050 object
 
+#define SENSOR_ERROR_TENTHS TENTHS(-999) // Read error (-999.0, as the CSV shows it)
+
 // Sensor data structure
 struct SensorData {
-  float temperature; // °C
-  float humidity;    // %
-  int gasLevel;      // 0-1023
-  int distance;      // cm
-  float pitch;       // degrees
-  float roll;        // degrees
-  float yaw;         // degrees
-  bool valid;        // All sensors read successfully
+  tenths_t temperature; // 0.1 °C
+  tenths_t humidity;    // 0.1 %
+  int gasLevel;         // 0-1023
+  int distance;         // cm
+  tenths_t pitch;       // 0.1 degree
+  tenths_t roll;        // 0.1 degree
+  tenths_t yaw;         // 0.1 degree
 };
 
+// Defined in the MPU6050 section below
+bool mpuReady = false;
+void calibrateGyro();
+bool startMPUFifo();
+
 // ==========================================
 // SENSOR INITIALIZATION
 // ==========================================
@@ -45,49 +59,82 @@ void initializeSensors() {
   Wire.begin();
 
   if (!mpu.begin()) {
-    Serial.println(F("Failed to find MPU6050 chip"));
+    LOG_ERROR(LOG_TAG_SENSOR, F("Failed to find MPU6050 chip"));
+    sensorDown(SENSOR_MPU, millis()); // updateMPU() keeps probing
   } else {
-    Serial.println(F("MPU6050 Found!"));
+    LOG_INFO(LOG_TAG_SENSOR, F("MPU6050 Found!"));
 
     // Configure MPU6050
     mpu.setAccelerometerRange(MPU6050_RANGE_8_G);
     mpu.setGyroRange(MPU6050_RANGE_500_DEG);
     mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
+    mpu.setSampleRateDivisor(1000 / IMU_RATE_HZ - 1); // 1 kHz / (1 + div)
 
-    Serial.println(F("MPU6050 configured"));
+    LOG_INFO(LOG_TAG_SENSOR, F("MPU6050 configured"));
+    mpuReady = true;
+    calibrateGyro();
+    startMPUFifo();
   }
 
+  // mpu.begin() re-runs Wire.begin(), so set the bus up afterwards
+  configureI2C();
+
   // MQ-2 is analog, no initialization needed
 
   // Initialize Ultrasonic sensor pins
   pinMode(TRIG_PIN, OUTPUT);
   pinMode(ECHO_PIN, INPUT);
   digitalWrite(TRIG_PIN, LOW); // Ensure trigger starts LOW
-  Serial.println(F("Ultrasonic sensor initialized"));
-
-  Serial.println(F("Sensors initialized"));
+#if defined(__AVR__)
+#if ECHO_PIN != 11
+#error "ECHO_PIN must be D11 (PCINT3) for the ranging interrupt"
+#endif
+  // Echo edges are timed by the pin-change interrupt (see updateRanging)
+  PCMSK0 |= _BV(PCINT3); // Only the echo pin on port B
+  PCIFR = _BV(PCIF0);    // Drop anything already latched
+  PCICR |= _BV(PCIE0);
+#endif
+  LOG_INFO(LOG_TAG_SENSOR, F("Ultrasonic sensor initialized"));
+
+  LOG_INFO(LOG_TAG_SENSOR, F("Sensors initialized"));
 }
 
 // ==========================================
 // DHT11 - Temperature & Humidity
 // ==========================================
 
-float readTemperature() {
+tenths_t readTemperature() {
   float temp = dht.readTemperature();
   if (isnan(temp)) {
-    Serial.println(F("DHT11: Temperature read error"));
-    return -999; // Error value
+    LOG_WARN(LOG_TAG_SENSOR, F("DHT11: Temperature read error"));
+    return SENSOR_ERROR_TENTHS;
   }
-  return temp;
+  return toTenths(temp);
 }
 
-float readHumidity() {
+tenths_t readHumidity() {
   float humid = dht.readHumidity();
   if (isnan(humid)) {
-    Serial.println(F("DHT11: Humidity read error"));
-    return -999; // Error value
+    LOG_WARN(LOG_TAG_SENSOR, F("DHT11: Humidity read error"));
+    return SENSOR_ERROR_TENTHS;
   }
-  return humid;
+  return toTenths(humid);
+}
+
+// Both readings (one transfer: the library keeps it for the second).
+// While the DHT11 is down only the retries read it, and the readings
+// stay SENSOR_ERROR_TENTHS from the reads that failed.
+void readClimate(SensorData &data) {
+  unsigned long now = millis();
+  if (!sensorDue(SENSOR_DHT, now)) {
+    return;
+  }
+  data.temperature = readTemperature();
+  data.humidity = readHumidity();
+  sensorResult(SENSOR_DHT,
+               data.temperature != SENSOR_ERROR_TENTHS &&
+                   data.humidity != SENSOR_ERROR_TENTHS,
+               now);
 }
 
 // ==========================================
@@ -95,6 +142,7 @@ float readHumidity() {
 // ==========================================
 
 int readGasLevel() {
+  PROFILE_SCOPE(PROF_GAS);
   int gasValue = analogRead(MQ2_PIN);
   // Gas sensor returns 0-1023
   return gasValue;
@@ -105,84 +153,414 @@ bool isHazardousGas(int gasLevel) { return gasLevel >= MQ2_THRESHOLD; }
 // ==========================================
 // Ultrasonic - Distance Sensor
 // ==========================================
+// Non-blocking ranging: updateRanging() fires a ping and returns; the
+// echo edges are timestamped by the pin-change interrupt on ECHO_PIN
+// (D11 = PB3, PCINT3) and the next call turns the pulse width into a
+// distance and fires the next ping, so there is one ping per task
+// period (RANGING_INTERVAL at the ALERT rate). readDistance() returns the latest result, distanceAge()
+// says how old it is. An HC-SR04 raises the echo pin after every ping,
+// even with nothing in range; a ping with no rising edge at all means
+// the sensor is gone (health.h).
+
+#define ECHO_TIMEOUT_US 30000UL // No echo after this = out of range
+#define ECHO_CM_PER_US q16Scale(0.034 / 2) // Speed of sound, halved for the round trip
+
+// Otherwise a call would find the echo still pending and skip a ping
+static_assert(ECHO_TIMEOUT_US < RANGING_INTERVAL * 1000UL,
+              "the echo must time out within the fastest ping period");
+
+// Echo pulse width to cm, or -1 if out of range
+int echoToDistance(unsigned long width) {
+  if (width == 0 || width > ECHO_TIMEOUT_US) {
+    return -1;
+  }
+  int distance = scaleQ16(width, ECHO_CM_PER_US);
+  return distance > MAX_DISTANCE ? -1 : distance;
+}
+
+volatile unsigned long echoRiseMicros = 0;
+volatile unsigned long echoWidthMicros = 0;
+volatile bool echoComplete = false;
+
+bool pingPending = false;
+unsigned long pingMicros = 0;
+int latestDistance = -1;          // cm, -1 = out of range / no reading yet
+unsigned long distanceTimestamp = 0; // millis() of latestDistance
+
+#if defined(__AVR__)
+ISR(PCINT0_vect) {
+  if (PINB & _BV(PINB3)) {
+    echoRiseMicros = micros();
+  } else if (echoRiseMicros != 0) {
+    echoWidthMicros = micros() - echoRiseMicros;
+    echoRiseMicros = 0;
+    echoComplete = true;
+  }
+}
+#endif
 
-int readDistance() {
-  // Send ultrasonic pulse (pins already configured in initializeSensors)
+void triggerPing() {
   digitalWrite(TRIG_PIN, LOW);
   delayMicroseconds(2);
   digitalWrite(TRIG_PIN, HIGH);
   delayMicroseconds(10);
   digitalWrite(TRIG_PIN, LOW);
+}
 
-  // Read echo
-  long duration = pulseIn(ECHO_PIN, HIGH, 30000); // 30ms timeout
-
-  // Calculate distance (speed of sound: 343 m/s or 0.034 cm/µs)
-  int distance = duration * 0.034 / 2;
+void publishDistance(int distance) {
+  // Only report the transition to out of range, not every ping
+  if (distance == -1 && latestDistance != -1) {
+    LOG_DEBUG(LOG_TAG_SENSOR, F("Ultrasonic: Out of range"));
+  }
+  latestDistance = distance;
+  distanceTimestamp = millis();
+}
 
-  // Validate range - allow 0-400cm, return -1 only if clearly invalid
-  if (duration == 0 || distance > MAX_DISTANCE) {
-    Serial.println(F("Ultrasonic: Out of range"));
-    return -1; // Error value
+// Called by the ranging task; returns true when a new distance was published
+bool updateRanging() {
+  PROFILE_SCOPE(PROF_RANGING);
+#if defined(__AVR__)
+  bool published = false;
+  if (pingPending) {
+    if (echoComplete) {
+      noInterrupts();
+      unsigned long width = echoWidthMicros;
+      echoComplete = false;
+      interrupts();
+      sensorResult(SENSOR_RANGING, true, millis());
+      publishDistance(echoToDistance(width));
+    } else if (micros() - pingMicros < ECHO_TIMEOUT_US) {
+      return false; // Echo still on its way
+    } else {
+      // No echo in time
+      noInterrupts(); // 4 bytes, shared with the ISR
+      bool echoStarted = echoRiseMicros != 0; // Rose, never fell: alive, out of range
+      echoRiseMicros = 0;
+      interrupts();
+      sensorResult(SENSOR_RANGING, echoStarted, millis());
+      publishDistance(-1);
+    }
+    pingPending = false;
+    published = true;
   }
 
-  return distance;
+  // Next ping right away, not on the next call
+  if (!sensorDue(SENSOR_RANGING, millis())) {
+    return published; // Down: ping again after the backoff
+  }
+  echoComplete = false;
+  triggerPing();
+  pingMicros = micros();
+  pingPending = true;
+  return published;
+#else
+  // No pin-change interrupt: fall back to the blocking measurement
+  triggerPing();
+  publishDistance(echoToDistance(pulseIn(ECHO_PIN, HIGH, ECHO_TIMEOUT_US)));
+  return true;
+#endif
 }
 
+int readDistance() { return latestDistance; }
+
+// Milliseconds since the last published distance
+unsigned long distanceAge() { return millis() - distanceTimestamp; }
+
 // ==========================================
-// MPU6050 - Orientation Sensor (Adafruit)
+// MPU6050 - Orientation Sensor
 // ==========================================
+// The Adafruit library configures the chip; after that the MPU's own
+// FIFO collects accel + gyro samples at IMU_RATE_HZ and updateMPU()
+// drains it in bursts (two 12-byte samples per I2C transaction, the
+// most the 32-byte Wire buffer holds) into a small ring of raw int16
+// samples. Each sample is fused with a fixed-point complementary filter:
+//   angle += gyro * dt                    (short term)
+//   angle += (accelAngle - angle) / 2^k   (long term, k = IMU_FUSION_SHIFT)
+// Angles are Q16 degrees (65536 = 1°), the accel angles come from the
+// CORDIC atan2Q16(). With the gyro at ±500 °/s (65.5 LSB per °/s),
+// raw * dt_us / 1000 is the angle change in Q16 to within 0.05%. Lost
+// samples are counted in imuOverflows (health.h).
+//
+// Any failed transfer counts against the MPU's health; once it is down
+// updateMPU() stops reading it and, each time its backoff runs out,
+// frees the bus and sets the chip up again from scratch.
+
+#define MPU_REG_SMPLRT_DIV 0x19
+#define MPU_REG_CONFIG 0x1A
+#define MPU_REG_GYRO_CONFIG 0x1B
+#define MPU_REG_ACCEL_CONFIG 0x1C
+#define MPU_REG_FIFO_EN 0x23
+#define MPU_REG_INT_STATUS 0x3A
+#define MPU_REG_ACCEL_XOUT_H 0x3B
+#define MPU_REG_USER_CTRL 0x6A
+#define MPU_REG_PWR_MGMT_1 0x6B
+#define MPU_REG_FIFO_COUNTH 0x72
+#define MPU_REG_FIFO_R_W 0x74
+
+// What initializeSensors() has the library set, as register values
+#define MPU_CLOCK_PLL_GYROX 0x01 // Awake, clocked from the X gyro
+#define MPU_CONFIG_DLPF_21HZ 0x04
+#define MPU_GYRO_500_DPS 0x08
+#define MPU_ACCEL_8G 0x10
+#define MPU_FIFO_ACCEL_GYRO 0x78 // XG, YG, ZG and ACCEL into the FIFO
+#define MPU_USER_FIFO_EN 0x40
+#define MPU_USER_FIFO_RESET 0x04
+#define MPU_INT_FIFO_OFLOW 0x10
+#define MPU_FIFO_SIZE 1024
+#define MPU_SAMPLE_BYTES 12      // Accel XYZ + gyro XYZ
+#define MPU_SAMPLES_PER_BURST 2  // 24 of the 32 Wire buffer bytes
+
+#define IMU_DT_US (1000000L / IMU_RATE_HZ) // Signed: it scales signed rates
+
+#define GYRO_CALIBRATION_SAMPLES 64
+
+struct ImuSample {
+  int16_t ax, ay, az; // Raw accel
+  int16_t gx, gy, gz; // Raw gyro
+};
 
-// Global sensor event objects
-sensors_event_t a, g, temp;
+struct Attitude {
+  q16_t pitch; // Degrees, -180..180
+  q16_t roll;  // Degrees, -180..180
+  q16_t yaw;   // Degrees, 0..360 (integrated, drifts slowly)
+  bool initialized;
+};
 
-void updateMPU() { mpu.getEvent(&a, &g, &temp); }
+Attitude attitude = {0, 0, 0, false};
+int16_t gyroBias[3] = {0, 0, 0};
 
-float readPitch() {
-  // Calculate pitch from accelerometer (tilt forward/backward)
-  return atan2(a.acceleration.y, a.acceleration.z) * 180.0 / PI;
+// Raw sample ring, filled from the FIFO and consumed by the fusion
+ImuSample imuRing[IMU_RING_SIZE];
+uint8_t imuRingHead = 0;  // Next slot to write
+uint8_t imuRingCount = 0; // Unconsumed samples
+
+bool writeMPURegister(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(MPU_ADDRESS);
+  Wire.write(reg);
+  Wire.write(value);
+  return Wire.endTransmission() == 0;
 }
 
-float readRoll() {
-  // Calculate roll from accelerometer (tilt left/right)
-  return atan2(-a.acceleration.x, a.acceleration.z) * 180.0 / PI;
+// Start a register read; the caller then reads `count` bytes from Wire
+bool requestMPU(uint8_t reg, uint8_t count) {
+  Wire.beginTransmission(MPU_ADDRESS);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0) {
+    return false;
+  }
+  return Wire.requestFrom((uint8_t)MPU_ADDRESS, count) == count;
 }
 
-float readYaw() {
-  // Yaw from gyroscope Z-axis
-  return g.gyro.z * 180.0 / PI;
+int16_t readWireWord() {
+  uint8_t high = Wire.read();
+  return (int16_t)((high << 8) | Wire.read());
 }
 
-// ==========================================
-// READ ALL SENSORS
-// ==========================================
+void readWireSample(ImuSample &sample) {
+  int16_t *words = &sample.ax;
+  for (uint8_t i = 0; i < 6; i++) {
+    words[i] = readWireWord();
+  }
+}
 
-SensorData readAllSensors() {
-  SensorData data;
+// Direct register read of one sample (used before the FIFO runs)
+bool readMPURegisters(ImuSample &sample) {
+  if (!requestMPU(MPU_REG_ACCEL_XOUT_H, 14)) {
+    return false;
+  }
+  sample.ax = readWireWord();
+  sample.ay = readWireWord();
+  sample.az = readWireWord();
+  readWireWord(); // Temperature, not used
+  sample.gx = readWireWord();
+  sample.gy = readWireWord();
+  sample.gz = readWireWord();
+  return true;
+}
 
-  // Read DHT11
-  data.temperature = readTemperature();
-  data.humidity = readHumidity();
+// Average the gyro at rest (called once from initializeSensors)
+void calibrateGyro() {
+  int32_t sum[3] = {0, 0, 0};
+  uint8_t samples = 0;
+  ImuSample sample;
+
+  for (uint8_t i = 0; i < GYRO_CALIBRATION_SAMPLES; i++) {
+    if (readMPURegisters(sample)) {
+      sum[0] += sample.gx;
+      sum[1] += sample.gy;
+      sum[2] += sample.gz;
+      samples++;
+    }
+    delay(2);
+  }
 
-  // Read MQ-2
-  data.gasLevel = readGasLevel();
+  if (samples > 0) {
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      gyroBias[axis] = sum[axis] / samples;
+    }
+  }
+  LOG_INFO(LOG_TAG_SENSOR, F("MPU6050 gyro calibrated"));
+}
 
-  // Read Ultrasonic
-  data.distance = readDistance();
+bool startMPUFifo() {
+  return writeMPURegister(MPU_REG_USER_CTRL, MPU_USER_FIFO_RESET) &&
+         writeMPURegister(MPU_REG_FIFO_EN, MPU_FIFO_ACCEL_GYRO) &&
+         writeMPURegister(MPU_REG_USER_CTRL, MPU_USER_FIFO_EN);
+}
+
+// Set the chip up again after a fault (a brown-out resets it to
+// defaults, and the bus may be stuck). Plain register writes: no
+// library delays, no gyro calibration, so the loop isn't held up;
+// the bias from boot (if the chip was there) still applies.
+bool restartMPU() {
+  recoverI2CBus();
+  if (!writeMPURegister(MPU_REG_PWR_MGMT_1, MPU_CLOCK_PLL_GYROX) ||
+      !writeMPURegister(MPU_REG_CONFIG, MPU_CONFIG_DLPF_21HZ) ||
+      !writeMPURegister(MPU_REG_GYRO_CONFIG, MPU_GYRO_500_DPS) ||
+      !writeMPURegister(MPU_REG_ACCEL_CONFIG, MPU_ACCEL_8G) ||
+      !writeMPURegister(MPU_REG_SMPLRT_DIV, 1000 / IMU_RATE_HZ - 1) ||
+      !startMPUFifo()) {
+    return false;
+  }
+  imuRingCount = 0;
+  attitude.initialized = false; // Re-seed from the accelerometer
+  LOG_INFO(LOG_TAG_SENSOR, F("MPU6050 restarted"));
+  return true;
+}
+
+void pushImuSample(const ImuSample &sample) {
+  if (imuRingCount == IMU_RING_SIZE) {
+    imuOverflows++; // Drop the oldest
+    imuRingCount--;
+  }
+  imuRing[imuRingHead] = sample;
+  imuRingHead = (imuRingHead + 1) % IMU_RING_SIZE;
+  imuRingCount++;
+}
+
+bool popImuSample(ImuSample &sample) {
+  if (imuRingCount == 0) {
+    return false;
+  }
+  uint8_t tail = (imuRingHead + IMU_RING_SIZE - imuRingCount) % IMU_RING_SIZE;
+  sample = imuRing[tail];
+  imuRingCount--;
+  return true;
+}
+
+// Move whatever the FIFO holds into the ring; false on a bus error
+bool drainMPUFifo() {
+  if (!requestMPU(MPU_REG_INT_STATUS, 1)) {
+    return false;
+  }
+  bool overflowed = Wire.read() & MPU_INT_FIFO_OFLOW;
+
+  if (!requestMPU(MPU_REG_FIFO_COUNTH, 2)) {
+    return false;
+  }
+  uint16_t count = (uint16_t)readWireWord();
+
+  // After an overflow (or a torn sample) the byte stream is misaligned
+  if (overflowed || count >= MPU_FIFO_SIZE || count % MPU_SAMPLE_BYTES != 0) {
+    imuOverflows++;
+    return startMPUFifo();
+  }
+
+  uint16_t available = count / MPU_SAMPLE_BYTES;
+  while (available > 0) {
+    uint8_t burst = available < MPU_SAMPLES_PER_BURST ? available
+                                                      : MPU_SAMPLES_PER_BURST;
+    if (!requestMPU(MPU_REG_FIFO_R_W, burst * MPU_SAMPLE_BYTES)) {
+      return false;
+    }
+    for (uint8_t i = 0; i < burst; i++) {
+      ImuSample sample;
+      readWireSample(sample);
+      pushImuSample(sample);
+    }
+    available -= burst;
+  }
+  return true;
+}
+
+q16_t fuseAngle(q16_t angle, q16_t gyroDelta, q16_t accelAngle) {
+  angle = wrapHalfTurn(angle + gyroDelta);
+  return wrapHalfTurn(angle +
+                      (wrapHalfTurn(accelAngle - angle) >> IMU_FUSION_SHIFT));
+}
+
+void fuseImuSample(const ImuSample &sample) {
+  // Tilt from gravity (same axes as before: pitch about X, roll about Y)
+  q16_t accelPitch = atan2Q16(sample.ay, sample.az);
+  q16_t accelRoll = atan2Q16(-sample.ax, sample.az);
+
+  if (!attitude.initialized) {
+    attitude.pitch = accelPitch;
+    attitude.roll = accelRoll;
+    attitude.yaw = 0;
+    attitude.initialized = true;
+    return;
+  }
+
+  // FIFO samples are exactly IMU_DT_US apart
+  q16_t deltaPitch = (int32_t)(sample.gx - gyroBias[0]) * IMU_DT_US / 1000;
+  q16_t deltaRoll = (int32_t)(sample.gy - gyroBias[1]) * IMU_DT_US / 1000;
+  q16_t deltaYaw = (int32_t)(sample.gz - gyroBias[2]) * IMU_DT_US / 1000;
+
+  attitude.pitch = fuseAngle(attitude.pitch, deltaPitch, accelPitch);
+  attitude.roll = fuseAngle(attitude.roll, deltaRoll, accelRoll);
+
+  // No magnetometer: yaw is the integrated gyro heading
+  attitude.yaw += deltaYaw;
+  if (attitude.yaw < 0)
+    attitude.yaw += Q16_FULL_TURN;
+  else if (attitude.yaw >= Q16_FULL_TURN)
+    attitude.yaw -= Q16_FULL_TURN;
+}
 
-  // Read MPU6050
-  updateMPU();
-  data.pitch = readPitch();
-  data.roll = readRoll();
-  data.yaw = readYaw();
+// Drain the FIFO and fuse every new sample; false if nothing new
+bool updateMPU() {
+  PROFILE_SCOPE(PROF_IMU);
+  unsigned long now = millis();
+  if (!mpuReady) {
+    if (!sensorDue(SENSOR_MPU, now)) {
+      return false;
+    }
+    mpuReady = restartMPU();
+    sensorResult(SENSOR_MPU, mpuReady, now);
+    if (!mpuReady) {
+      return false;
+    }
+  }
+
+  bool ok = drainMPUFifo();
+  sensorResult(SENSOR_MPU, ok, now);
+  if (!sensorHealthy(SENSOR_MPU)) {
+    mpuReady = false; // Restarted once the backoff runs out
+  }
 
-  // Check if critical sensors failed (only check for explicit error values,
-  // allow zero) DHT can return 0.0 in dry conditions, ultrasonic can be -1 if
-  // out of range
-  data.valid = (data.temperature != -999) && (data.humidity != -999);
-  // Note: Distance can be -1 (out of range) but that's not a critical error
+  bool updated = false;
+  ImuSample sample;
+  while (popImuSample(sample)) {
+    fuseImuSample(sample);
+    updated = true;
+  }
+  return updated;
+}
+
+tenths_t readPitch() {
+  // Fused pitch (tilt forward/backward)
+  return q16ToTenths(attitude.pitch);
+}
+
+tenths_t readRoll() {
+  // Fused roll (tilt left/right)
+  return q16ToTenths(attitude.roll);
+}
 
-  return data;
+tenths_t readYaw() {
+  // Integrated heading since power-up, 0-360
+  return q16ToTenths(attitude.yaw);
 }
 
 #endif // SENSORS_H
@@ -0,0 +1,30 @@
+/*
+ * Host Adafruit_MPU6050 for the Disaster Recon UAV Simulation
+ *
+ * Configuration calls land in the register model in hal.cpp (only
+ * the sample rate matters to it); readings are taken through Wire.
+ */
+
+#ifndef SIM_ADAFRUIT_MPU6050_H
+#define SIM_ADAFRUIT_MPU6050_H
+
+#include "Adafruit_Sensor.h"
+#include "Wire.h"
+
+#define MPU6050_I2CADDR_DEFAULT 0x68
+
+enum { MPU6050_RANGE_8_G = 2 };
+enum { MPU6050_RANGE_500_DEG = 1 };
+enum { MPU6050_BAND_21_HZ = 4 };
+
+class Adafruit_MPU6050 {
+public:
+  bool begin(uint8_t address = MPU6050_I2CADDR_DEFAULT, TwoWire *wire = &Wire,
+             int32_t sensorId = 0);
+  void setAccelerometerRange(int range) {}
+  void setGyroRange(int range) {}
+  void setFilterBandwidth(int bandwidth) {}
+  void setSampleRateDivisor(uint8_t divisor);
+};
+
+#endif // SIM_ADAFRUIT_MPU6050_H
@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for Adafruit_Sensor.h (the sketch only includes it)
+ */
+
+#ifndef SIM_ADAFRUIT_SENSOR_H
+#define SIM_ADAFRUIT_SENSOR_H
+
+struct sensors_vec_t {
+  float x, y, z;
+};
+
+struct sensors_event_t {
+  sensors_vec_t acceleration;
+  sensors_vec_t gyro;
+  float temperature;
+};
+
+#endif // SIM_ADAFRUIT_SENSOR_H
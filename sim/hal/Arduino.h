@@ -0,0 +1,162 @@
+/*
+ * Host Arduino Core for the Disaster Recon UAV Simulation
+ *
+ * Just enough of the Arduino API for the sketch to build natively:
+ * - Time comes from the simulated clock in sim_hal.h; delay() and
+ *   pulseIn() advance it instead of waiting
+ * - Pins, analogRead() and tone() read and write the simulated world
+ * - Serial bytes go to a sink the driver installs, and the driver
+ *   feeds what the bridge would send back
+ *
+ * PROGMEM is ordinary memory here, so the _P helpers are the plain
+ * string functions. No __AVR__, so the sketch takes its host paths.
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define F_CPU 16000000UL
+#define PI 3.1415926535897932384626433832795
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define SIM_PIN_COUNT 20
+
+#define _BV(bit) (1 << (bit))
+
+// ==========================================
+// PROGRAM MEMORY
+// ==========================================
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define PGM_P const char *
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+// ==========================================
+// CORE FUNCTIONS
+// ==========================================
+
+#define noInterrupts()
+#define interrupts()
+#define digitalPinToInterrupt(pin) (pin)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+unsigned long pulseIn(uint8_t pin, uint8_t state,
+                      unsigned long timeout = 1000000UL);
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isAlpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+template <class T> T constrain(T x, T low, T high) {
+  return x < low ? low : (x > high ? high : x);
+}
+
+// ==========================================
+// PRINT / STREAM / SERIAL
+// ==========================================
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const __FlashStringHelper *s) { return print((const char *)s); }
+  size_t print(const char *s);
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned value, int base = DEC) {
+    return print((unsigned long)value, base);
+  }
+  size_t print(uint8_t value, int base = DEC) {
+    return print((unsigned long)value, base);
+  }
+  size_t print(double value, int digits = 2);
+
+  size_t println() { return print("\r\n"); }
+  template <class T> size_t println(T value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <class T, class U> size_t println(T value, U format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+class HardwareSerial : public Stream {
+public:
+  using Print::write;
+  void begin(unsigned long baud);
+  void end() {}
+  void flush() {}
+  int availableForWrite();
+  size_t write(uint8_t c) override;
+  int available() override;
+  int read() override;
+  operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,23 @@
+/*
+ * Host DHT sensor library for the Disaster Recon UAV Simulation
+ *
+ * Readings come from the simulated world; a failed read is NAN, as
+ * on the real sensor.
+ */
+
+#ifndef SIM_DHT_H
+#define SIM_DHT_H
+
+#include "Arduino.h"
+
+#define DHT11 11
+
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type) {}
+  void begin() {}
+  float readTemperature();
+  float readHumidity();
+};
+
+#endif // SIM_DHT_H
@@ -0,0 +1,34 @@
+/*
+ * Host IRremote for the Disaster Recon UAV Simulation
+ *
+ * simPressIR() (sim_hal.h) queues a code for decode(), and calls the
+ * receive-complete callback if the sketch registered one.
+ */
+
+#ifndef SIM_IRREMOTE_HPP
+#define SIM_IRREMOTE_HPP
+
+#include "Arduino.h"
+
+#define ENABLE_LED_FEEDBACK true
+#define IRDATA_FLAGS_IS_REPEAT 0x01
+
+struct IRData {
+  uint32_t decodedRawData;
+  uint16_t command;
+  uint8_t flags;
+};
+
+class IRrecv {
+public:
+  void begin(uint8_t pin, bool ledFeedback = false) {}
+  bool decode();
+  void resume();
+  void registerReceiveCompleteCallback(void (*callback)());
+
+  IRData decodedIRData = {0, 0, 0};
+};
+
+extern IRrecv IrReceiver;
+
+#endif // SIM_IRREMOTE_HPP
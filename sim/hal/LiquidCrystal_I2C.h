@@ -0,0 +1,36 @@
+/*
+ * Host LiquidCrystal_I2C for the Disaster Recon UAV Simulation
+ *
+ * Keeps the characters the sketch writes, so the driver can show
+ * what the LCD would.
+ */
+
+#ifndef SIM_LIQUIDCRYSTAL_I2C_H
+#define SIM_LIQUIDCRYSTAL_I2C_H
+
+#include "Arduino.h"
+
+#define SIM_LCD_COLS 20
+#define SIM_LCD_ROWS 4
+
+class LiquidCrystal_I2C : public Print {
+public:
+  using Print::write;
+  LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows);
+  void init() { clear(); }
+  void backlight() {}
+  void noBacklight() {}
+  void clear();
+  void setCursor(uint8_t col, uint8_t row);
+  size_t write(uint8_t c) override;
+
+  // Row contents for the simulation driver
+  const char *row(uint8_t row) const { return text[row]; }
+
+private:
+  uint8_t cols, rows;
+  uint8_t col = 0, line = 0;
+  char text[SIM_LCD_ROWS][SIM_LCD_COLS + 1];
+};
+
+#endif // SIM_LIQUIDCRYSTAL_I2C_H
@@ -0,0 +1,38 @@
+/*
+ * Host Wire (I2C) for the Disaster Recon UAV Simulation
+ *
+ * Transactions addressed to the MPU6050 go to its register model in
+ * hal.cpp; any other address NACKs like an empty bus.
+ */
+
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+public:
+  void begin() {}
+  void end() {}
+  void setClock(unsigned long clock) {}
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool sendStop = true);
+  size_t write(uint8_t data);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = 1);
+  int available();
+  int read();
+
+private:
+  uint8_t address = 0;
+  uint8_t txBuffer[BUFFER_LENGTH];
+  uint8_t txLength = 0;
+  uint8_t rxBuffer[BUFFER_LENGTH];
+  uint8_t rxLength = 0;
+  uint8_t rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
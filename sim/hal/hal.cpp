@@ -0,0 +1,486 @@
+/*
+ * Host HAL for the Disaster Recon UAV Simulation
+ *
+ * Implements the Arduino core and library calls declared in this
+ * directory on top of the simulated world (sim_hal.h).
+ *
+ * The MPU6050 is modelled at register level because sensors.h talks
+ * to it directly: its FIFO fills at the configured sample rate while
+ * simulated time passes, overflows like the chip when not drained,
+ * and each sample is accel + gyro from simWorld's attitude.
+ */
+
+#include "Adafruit_MPU6050.h"
+#include "Arduino.h"
+#include "DHT.h"
+#include "IRremote.hpp"
+#include "LiquidCrystal_I2C.h"
+#include "Wire.h"
+#include "sim_hal.h"
+
+#include <string>
+
+SimWorld simWorld = {22.0f, 45.0f, 120, 150.0f, 0.0f, 0.0f, 0.0f, true};
+SimOutputs simOutputs = {};
+
+HardwareSerial Serial;
+TwoWire Wire;
+IRrecv IrReceiver;
+
+// ==========================================
+// CLOCK
+// ==========================================
+
+static uint64_t nowMicros = 0;
+
+uint64_t simMicros() { return nowMicros; }
+
+void simAdvance(uint64_t us) { nowMicros += us; }
+
+unsigned long millis() { return nowMicros / 1000; }
+
+unsigned long micros() { return nowMicros; }
+
+void delay(unsigned long ms) { simAdvance((uint64_t)ms * 1000); }
+
+void delayMicroseconds(unsigned int us) { simAdvance(us); }
+
+// ==========================================
+// PINS AND TONE
+// ==========================================
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < SIM_PIN_COUNT) {
+    simOutputs.pins[pin] = value ? HIGH : LOW;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < SIM_PIN_COUNT ? simOutputs.pins[pin] : LOW;
+}
+
+// The MQ-2 is the only analog input on the board
+int analogRead(uint8_t pin) { return constrain(simWorld.gasLevel, 0, 1023); }
+
+void analogWrite(uint8_t pin, int value) {
+  if (pin < SIM_PIN_COUNT) {
+    simOutputs.pwm[pin] = value;
+  }
+}
+
+// The ultrasonic echo is the only pulse input: its width for the
+// distance in simWorld, taking as long as the real measurement would
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+  // Round trip at 0.034 cm/us, rounded up so width * 17 / 1000 is exact
+  unsigned long width =
+      simWorld.distance < 0 ? 0 : (unsigned long)ceil(simWorld.distance * 1000 / 17);
+  if (width == 0 || width > timeout) {
+    simAdvance(timeout);
+    return 0;
+  }
+  simAdvance(width);
+  return width;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode) {}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) {
+  simOutputs.toneHz = frequency;
+}
+
+void noTone(uint8_t pin) { simOutputs.toneHz = 0; }
+
+// ==========================================
+// PRINT AND SERIAL
+// ==========================================
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    write(buffer[i]);
+  }
+  return size;
+}
+
+size_t Print::print(const char *s) {
+  size_t n = 0;
+  while (*s) {
+    n += write((uint8_t)*s++);
+  }
+  return n;
+}
+
+size_t Print::print(long value, int base) {
+  if (base == HEX) {
+    return print((unsigned long)value, base);
+  }
+  char text[24];
+  snprintf(text, sizeof(text), "%ld", value);
+  return print(text);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+  return print(text);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+#define SIM_SERIAL_TX_ROOM 63 // SERIAL_TX_BUFFER_SIZE - 1 on the Uno
+
+static SimSerialSink serialSink = NULL;
+static std::string serialInput;
+static size_t serialInputPos = 0;
+static unsigned long serialBaud = 0;
+
+void simSetSerialSink(SimSerialSink sink) { serialSink = sink; }
+
+void simSerialInput(const char *data, size_t length) {
+  serialInput.append(data, length);
+}
+
+void simSerialInput(const char *line) {
+  serialInput.append(line);
+  serialInput.append("\r\n");
+}
+
+unsigned long simSerialBaud() { return serialBaud; }
+
+void HardwareSerial::begin(unsigned long baud) { serialBaud = baud; }
+
+// Output leaves as soon as it is written, so there is always room
+int HardwareSerial::availableForWrite() { return SIM_SERIAL_TX_ROOM; }
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (serialSink) {
+    serialSink(c);
+  }
+  return 1;
+}
+
+int HardwareSerial::available() {
+  return serialInput.size() - serialInputPos;
+}
+
+int HardwareSerial::read() {
+  if (serialInputPos == serialInput.size()) {
+    return -1;
+  }
+  int c = (uint8_t)serialInput[serialInputPos++];
+  if (serialInputPos == serialInput.size()) {
+    serialInput.clear();
+    serialInputPos = 0;
+  }
+  return c;
+}
+
+// ==========================================
+// DHT11
+// ==========================================
+
+float DHT::readTemperature() { return simWorld.temperature; }
+
+float DHT::readHumidity() { return simWorld.humidity; }
+
+// ==========================================
+// IR RECEIVER
+// ==========================================
+
+static bool irPending = false;
+static uint32_t irCode = 0;
+static void (*irCallback)() = NULL;
+
+void simPressIR(uint32_t code) {
+  irCode = code;
+  irPending = true;
+  if (irCallback) {
+    irCallback(); // Where the receiver ISR would call it
+  }
+}
+
+bool IRrecv::decode() {
+  if (!irPending) {
+    return false;
+  }
+  irPending = false;
+  decodedIRData.decodedRawData = irCode;
+  decodedIRData.command = (irCode >> 16) & 0xFF;
+  decodedIRData.flags = 0;
+  return true;
+}
+
+void IRrecv::resume() {}
+
+void IRrecv::registerReceiveCompleteCallback(void (*callback)()) {
+  irCallback = callback;
+}
+
+// ==========================================
+// LCD
+// ==========================================
+
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t address, uint8_t cols,
+                                     uint8_t rows)
+    : cols(cols < SIM_LCD_COLS ? cols : SIM_LCD_COLS),
+      rows(rows < SIM_LCD_ROWS ? rows : SIM_LCD_ROWS) {
+  clear();
+}
+
+void LiquidCrystal_I2C::clear() {
+  for (uint8_t r = 0; r < SIM_LCD_ROWS; r++) {
+    memset(text[r], ' ', cols);
+    text[r][cols] = '\0';
+  }
+  col = 0;
+  line = 0;
+}
+
+void LiquidCrystal_I2C::setCursor(uint8_t newCol, uint8_t newRow) {
+  col = newCol;
+  line = newRow < rows ? newRow : rows - 1;
+}
+
+size_t LiquidCrystal_I2C::write(uint8_t c) {
+  if (col < cols) {
+    text[line][col++] = c;
+  }
+  return 1;
+}
+
+// ==========================================
+// MPU6050 REGISTER MODEL
+// ==========================================
+
+#define MPU_SIM_ADDRESS 0x68
+#define MPU_SIM_SMPLRT_DIV 0x19
+#define MPU_SIM_FIFO_EN 0x23
+#define MPU_SIM_INT_STATUS 0x3A
+#define MPU_SIM_ACCEL_XOUT_H 0x3B
+#define MPU_SIM_USER_CTRL 0x6A
+#define MPU_SIM_FIFO_COUNTH 0x72
+#define MPU_SIM_FIFO_COUNTL 0x73
+#define MPU_SIM_FIFO_R_W 0x74
+
+#define MPU_SIM_FIFO_SIZE 1024
+#define MPU_SIM_SAMPLE_BYTES 12 // Accel + gyro, the sketch's FIFO_EN setting
+#define MPU_SIM_ACCEL_LSB 4096.0f // ±8 g
+#define MPU_SIM_GYRO_LSB 65.5f    // ±500 °/s
+
+static uint8_t mpuRateDivisor = 0;
+static uint8_t mpuFifoEnable = 0;
+static uint8_t mpuUserCtrl = 0;
+static uint8_t mpuRegister = 0;
+static bool mpuOverflow = false;
+static uint16_t mpuFifoCount = 0;    // Bytes in the FIFO
+static uint64_t mpuFifoClock = 0;    // Time of the last sample taken in
+static uint8_t mpuSampleBytes[MPU_SIM_SAMPLE_BYTES];
+static uint8_t mpuSampleOffset = MPU_SIM_SAMPLE_BYTES; // Next byte to read
+static float mpuLastPitch = 0, mpuLastRoll = 0;
+
+static uint64_t mpuSamplePeriod() { return 1000UL * (1 + mpuRateDivisor); }
+
+static bool mpuFifoRunning() {
+  return (mpuUserCtrl & 0x40) && mpuFifoEnable != 0;
+}
+
+static int16_t saturate16(float value) {
+  return value > 32767 ? 32767 : (value < -32768 ? -32768 : (int16_t)value);
+}
+
+// Raw accel + gyro words for the current world attitude
+static void mpuCurrentSample(int16_t words[6]) {
+  // Gravity arranged so atan2(ay, az) and atan2(-ax, az) give back
+  // pitch and roll exactly
+  float tanPitch = tan(simWorld.pitch * PI / 180);
+  float tanRoll = tan(simWorld.roll * PI / 180);
+  float az = 1 / sqrt(1 + tanPitch * tanPitch + tanRoll * tanRoll);
+  words[0] = saturate16(-tanRoll * az * MPU_SIM_ACCEL_LSB);
+  words[1] = saturate16(tanPitch * az * MPU_SIM_ACCEL_LSB);
+  words[2] = saturate16(az * MPU_SIM_ACCEL_LSB);
+
+  // Gyro: the attitude change since the previous sample, plus yaw
+  float dt = mpuSamplePeriod() / 1e6f;
+  words[3] = saturate16((simWorld.pitch - mpuLastPitch) / dt * MPU_SIM_GYRO_LSB);
+  words[4] = saturate16((simWorld.roll - mpuLastRoll) / dt * MPU_SIM_GYRO_LSB);
+  words[5] = saturate16(simWorld.yawRate * MPU_SIM_GYRO_LSB);
+  mpuLastPitch = simWorld.pitch;
+  mpuLastRoll = simWorld.roll;
+}
+
+static void mpuResetFifo() {
+  mpuFifoCount = 0;
+  mpuFifoClock = nowMicros;
+  mpuSampleOffset = MPU_SIM_SAMPLE_BYTES;
+  mpuOverflow = false;
+}
+
+// Take in the samples produced since the last call
+static void mpuFillFifo() {
+  if (!mpuFifoRunning()) {
+    mpuFifoClock = nowMicros;
+    return;
+  }
+  uint64_t due = (nowMicros - mpuFifoClock) / mpuSamplePeriod();
+  mpuFifoClock += due * mpuSamplePeriod();
+
+  uint64_t bytes = mpuFifoCount + due * MPU_SIM_SAMPLE_BYTES;
+  if (bytes > MPU_SIM_FIFO_SIZE) {
+    // The chip keeps writing over the oldest bytes: the count pins at
+    // the size and the stream loses its sample alignment
+    mpuOverflow = true;
+    bytes = MPU_SIM_FIFO_SIZE;
+  }
+  mpuFifoCount = bytes;
+}
+
+// Samples are made when they are read out, from the world as it is then
+static uint8_t mpuReadFifoByte() {
+  if (mpuFifoCount == 0) {
+    return 0xFF;
+  }
+  if (mpuSampleOffset == MPU_SIM_SAMPLE_BYTES) {
+    int16_t words[6];
+    mpuCurrentSample(words);
+    for (uint8_t i = 0; i < 6; i++) {
+      mpuSampleBytes[2 * i] = words[i] >> 8;
+      mpuSampleBytes[2 * i + 1] = words[i] & 0xFF;
+    }
+    mpuSampleOffset = 0;
+  }
+  mpuFifoCount--;
+  return mpuSampleBytes[mpuSampleOffset++];
+}
+
+static uint8_t mpuReadRegister(uint8_t reg) {
+  static int16_t snapshot[7]; // ACCEL_XOUT_H..GYRO_ZOUT_L, taken at XOUT_H
+  switch (reg) {
+  case MPU_SIM_INT_STATUS: {
+    mpuFillFifo();
+    uint8_t status = mpuOverflow ? 0x10 : 0;
+    mpuOverflow = false; // Cleared by the read
+    return status;
+  }
+  case MPU_SIM_FIFO_COUNTH:
+    mpuFillFifo();
+    return mpuFifoCount >> 8;
+  case MPU_SIM_FIFO_COUNTL:
+    return mpuFifoCount & 0xFF;
+  case MPU_SIM_FIFO_R_W:
+    return mpuReadFifoByte();
+  default:
+    break;
+  }
+
+  if (reg >= MPU_SIM_ACCEL_XOUT_H && reg < MPU_SIM_ACCEL_XOUT_H + 14) {
+    uint8_t index = reg - MPU_SIM_ACCEL_XOUT_H;
+    if (index == 0) {
+      int16_t words[6];
+      mpuCurrentSample(words);
+      snapshot[0] = words[0];
+      snapshot[1] = words[1];
+      snapshot[2] = words[2];
+      snapshot[3] = 0; // Die temperature, unused
+      snapshot[4] = words[3];
+      snapshot[5] = words[4];
+      snapshot[6] = words[5];
+    }
+    int16_t word = snapshot[index / 2];
+    return index % 2 == 0 ? word >> 8 : word & 0xFF;
+  }
+  return 0;
+}
+
+static void mpuWriteRegister(uint8_t reg, uint8_t value) {
+  switch (reg) {
+  case MPU_SIM_SMPLRT_DIV:
+    mpuRateDivisor = value;
+    break;
+  case MPU_SIM_FIFO_EN:
+    mpuFillFifo();
+    mpuFifoEnable = value;
+    break;
+  case MPU_SIM_USER_CTRL:
+    mpuFillFifo();
+    if (value & 0x04) {
+      mpuResetFifo();
+    }
+    mpuUserCtrl = value & ~0x04; // Reset bit clears itself
+    break;
+  }
+}
+
+bool Adafruit_MPU6050::begin(uint8_t address, TwoWire *wire, int32_t sensorId) {
+  mpuRateDivisor = 0;
+  mpuFifoEnable = 0;
+  mpuUserCtrl = 0;
+  mpuResetFifo();
+  mpuLastPitch = simWorld.pitch; // Powered up at rest
+  mpuLastRoll = simWorld.roll;
+  return simWorld.mpuPresent;
+}
+
+void Adafruit_MPU6050::setSampleRateDivisor(uint8_t divisor) {
+  mpuWriteRegister(MPU_SIM_SMPLRT_DIV, divisor);
+}
+
+// ==========================================
+// WIRE
+// ==========================================
+
+static bool wireAcknowledges(uint8_t address) {
+  return address == MPU_SIM_ADDRESS && simWorld.mpuPresent;
+}
+
+void TwoWire::beginTransmission(uint8_t to) {
+  address = to;
+  txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (txLength == BUFFER_LENGTH) {
+    return 0;
+  }
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  if (!wireAcknowledges(address)) {
+    return 2; // Address NACK
+  }
+  if (txLength > 0) {
+    mpuRegister = txBuffer[0];
+    for (uint8_t i = 1; i < txLength; i++) {
+      mpuWriteRegister(mpuRegister++, txBuffer[i]);
+    }
+  }
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t from, uint8_t quantity, uint8_t sendStop) {
+  rxLength = 0;
+  rxIndex = 0;
+  if (!wireAcknowledges(from)) {
+    return 0;
+  }
+  if (quantity > BUFFER_LENGTH) {
+    quantity = BUFFER_LENGTH;
+  }
+  for (uint8_t i = 0; i < quantity; i++) {
+    rxBuffer[rxLength++] = mpuReadRegister(mpuRegister);
+    if (mpuRegister != MPU_SIM_FIFO_R_W) {
+      mpuRegister++; // The FIFO port doesn't auto-increment
+    }
+  }
+  return rxLength;
+}
+
+int TwoWire::available() { return rxLength - rxIndex; }
+
+int TwoWire::read() { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
@@ -0,0 +1,55 @@
+/*
+ * Simulation Controls for the Disaster Recon UAV Host Build
+ *
+ * The other side of the host HAL: the driver sets the world the
+ * sensors see, moves the clock and plays the part of the bridge.
+ * - simWorld: what the DHT11, MQ-2, ultrasonic and MPU6050 measure
+ * - simAdvance(): nothing moves the clock except this, delay() and
+ *   the blocking pulseIn()
+ * - Serial output goes to the installed sink; simSerialInput() queues
+ *   bytes for Serial.read()
+ */
+
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include "Arduino.h"
+#include <stddef.h>
+#include <stdint.h>
+
+struct SimWorld {
+  float temperature; // °C, NAN = DHT read fails
+  float humidity;    // %, NAN = DHT read fails
+  int gasLevel;      // MQ-2 ADC counts 0-1023
+  float distance;    // cm to the nearest obstacle, < 0 = no echo
+  float pitch;       // Degrees, from gravity
+  float roll;        // Degrees, from gravity
+  float yawRate;     // Degrees per second
+  bool mpuPresent;   // false = MPU6050 missing from the bus
+};
+
+// IO the sketch drove, for the driver to inspect
+struct SimOutputs {
+  uint8_t pins[SIM_PIN_COUNT];
+  int pwm[SIM_PIN_COUNT];
+  unsigned int toneHz; // 0 = silent
+};
+
+extern SimWorld simWorld;
+extern SimOutputs simOutputs;
+
+// Clock, in microseconds since power-up
+uint64_t simMicros();
+void simAdvance(uint64_t us);
+
+// Serial
+typedef void (*SimSerialSink)(uint8_t c);
+void simSetSerialSink(SimSerialSink sink); // NULL = discard
+void simSerialInput(const char *data, size_t length);
+void simSerialInput(const char *line); // Adds the "\r\n"
+unsigned long simSerialBaud();
+
+// IR remote button press
+void simPressIR(uint32_t code);
+
+#endif // SIM_HAL_H
@@ -0,0 +1,479 @@
+/*
+ * Host Simulation Driver for Disaster Recon UAV
+ *
+ * Builds the unmodified sketch against the host HAL in hal/ and runs
+ * it at full CPU speed:
+ *   uav_sim [-v] [-c us] replay TRACE  Replay a recorded sensor trace
+ *   uav_sim [-n count] bench           Throughput benchmarks
+ *
+ * Traces are the sketch's own CSV telemetry with a leading timestamp:
+ *   ms,temp,humid,gas,dist,state,pitch,roll,yaw
+ * (state is ignored; -999 marks a failed DHT read and distance -1 no
+ * echo, as in the uplink). Each row holds until the next row's time.
+ *
+ * While replaying, the driver stands in for the Python bridge: it
+ * answers CONNECT_CLOUD and PING, and echoes every CSV sample back as a
+ * ThingSpeak downlink line so the parser runs too.
+ */
+
+#include <Arduino.h>
+
+#include "../UAV_Telemetry_Proto.ino"
+#include "sim_hal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define SIM_DEFAULT_LOOP_COST_US 200 // Simulated time per loop() pass
+#define SIM_DEFAULT_BENCH_COUNT 1000000UL
+#define SIM_TRACE_FIELDS 9
+
+static bool verbose = false;
+
+static double wallSeconds() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static double simSeconds() { return simMicros() / 1e6; }
+
+// ==========================================
+// BRIDGE STAND-IN
+// ==========================================
+// Splits the serial output into text lines and binary frames (frame.h
+// layout), counts telemetry and answers like the bridge would.
+
+struct BridgeStats {
+  unsigned long lines;
+  unsigned long frames;
+  unsigned long samples; // CSV lines or telemetry frames
+  unsigned long sampleBytes; // Link bytes they took, framing included
+  unsigned long downlinkLines;
+};
+
+static BridgeStats bridge = {0, 0, 0, 0, 0};
+static std::string bridgeLine;
+static uint8_t frameHeader[FRAME_HEADER_SIZE];
+static uint8_t frameHeaderLength = 0;
+static int frameRemaining = -1; // Payload + CRC still to skip, -1 = text
+
+static bool isCsvSample(const std::string &line) {
+  int commas = 0;
+  for (char c : line) {
+    commas += c == ',';
+  }
+  // Eight fields, plus the device ID and health flags on current sketches
+  return commas >= 7 && commas <= 9 && (isDigit(line[0]) || line[0] == '-');
+}
+
+static void bridgeHandleLine(const std::string &line) {
+  bridge.lines++;
+  if (verbose) {
+    printf("[%10.3f s] %s\n", simSeconds(), line.c_str());
+  }
+
+  if (line.compare(0, 13, "CONNECT_CLOUD") == 0) {
+    simSerialInput("CLOUD_OK"); // Accept, but stay at the boot rate
+  } else if (line == "PING") {
+    simSerialInput("PONG");
+  } else if (isCsvSample(line)) {
+    bridge.samples++;
+    bridge.sampleBytes += line.size() + 2; // "\r\n"
+    // Read-back of the same sample, '|' separated like the bridge sends
+    // (the channel has no device or health field)
+    std::string downlinkLine = line;
+    while (std::count(downlinkLine.begin(), downlinkLine.end(), ',') > 7) {
+      downlinkLine.resize(downlinkLine.rfind(','));
+    }
+    for (char &c : downlinkLine) {
+      c = c == ',' ? '|' : c;
+    }
+    simSerialInput(downlinkLine.c_str());
+    bridge.downlinkLines++;
+  }
+}
+
+static void bridgeSink(uint8_t c) {
+  if (frameRemaining > 0) {
+    frameRemaining--;
+    if (frameRemaining == 0) {
+      frameRemaining = -1;
+    }
+    return;
+  }
+
+  if (frameHeaderLength > 0 || (bridgeLine.empty() && c == FRAME_SYNC)) {
+    frameHeader[frameHeaderLength++] = c;
+    if (frameHeaderLength == FRAME_HEADER_SIZE) {
+      frameHeaderLength = 0;
+      frameRemaining = frameHeader[3] + FRAME_CRC_SIZE;
+      bridge.frames++;
+      uint8_t type = frameHeader[1] & 0x0F;
+      if (type == FRAME_TELEMETRY || type == FRAME_TELEMETRY_DELTA) {
+        bridge.samples++;
+        bridge.sampleBytes += FRAME_HEADER_SIZE + frameRemaining;
+      }
+    }
+    return;
+  }
+
+  if (c == '\n') {
+    if (!bridgeLine.empty() && bridgeLine.back() == '\r') {
+      bridgeLine.pop_back();
+    }
+    bridgeHandleLine(bridgeLine);
+    bridgeLine.clear();
+  } else {
+    bridgeLine += (char)c;
+  }
+}
+
+// ==========================================
+// RUNNING THE SKETCH
+// ==========================================
+
+struct RunStats {
+  unsigned long passes;
+  unsigned long stateChanges;
+  unsigned long hazardsShown;
+};
+
+static RunStats run = {0, 0, 0};
+static unsigned long loopCostUs = SIM_DEFAULT_LOOP_COST_US;
+
+static void bootSketch() {
+  simSetSerialSink(bridgeSink);
+  setup();
+  simPressIR(IR_BUTTON_ON);
+}
+
+// Run loop() passes until the clock reaches `until`
+static void runUntil(uint64_t until) {
+  while (simMicros() < until) {
+    int stateBefore = currentState;
+    uint8_t hazardBefore = hazardShown;
+
+    loop();
+    simAdvance(loopCostUs);
+    run.passes++;
+
+    if (currentState != stateBefore) {
+      run.stateChanges++;
+      if (verbose) {
+        printf("[%10.3f s] State %d -> %d\n", simSeconds(), stateBefore,
+               currentState);
+      }
+    }
+    if (hazardShown != hazardBefore && hazardShown != HAZARD_NONE) {
+      run.hazardsShown++;
+      if (verbose) {
+        printf("[%10.3f s] LCD: %s\n", simSeconds(),
+               hazardRules[hazardShown].title);
+      }
+    }
+  }
+}
+
+// ==========================================
+// TRACE REPLAY
+// ==========================================
+
+struct TraceRow {
+  unsigned long ms;
+  float temperature, humidity;
+  int gasLevel;
+  float distance;
+  float pitch, roll, yaw;
+};
+
+static bool loadTrace(const char *path, std::vector<TraceRow> &rows) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+
+  char line[256];
+  unsigned lineNumber = 0;
+  while (fgets(line, sizeof(line), file)) {
+    lineNumber++;
+    if (!isDigit(line[0])) {
+      continue; // Header or comment
+    }
+
+    double values[SIM_TRACE_FIELDS];
+    char *cursor = line;
+    int fields = 0;
+    while (fields < SIM_TRACE_FIELDS) {
+      char *end;
+      values[fields] = strtod(cursor, &end);
+      if (end == cursor) {
+        break;
+      }
+      fields++;
+      cursor = end + (*end == ',');
+    }
+    if (fields != SIM_TRACE_FIELDS) {
+      fprintf(stderr, "%s:%u: expected %d fields\n", path, lineNumber,
+              SIM_TRACE_FIELDS);
+      fclose(file);
+      return false;
+    }
+
+    TraceRow row;
+    row.ms = values[0];
+    row.temperature = values[1] == -999 ? NAN : values[1];
+    row.humidity = values[2] == -999 ? NAN : values[2];
+    row.gasLevel = values[3];
+    row.distance = values[4];
+    row.pitch = values[6];
+    row.roll = values[7];
+    row.yaw = values[8];
+    rows.push_back(row);
+  }
+  fclose(file);
+
+  if (rows.empty()) {
+    fprintf(stderr, "%s: no samples\n", path);
+    return false;
+  }
+  return true;
+}
+
+static void applyTraceRow(const TraceRow &row, const TraceRow *next) {
+  simWorld.temperature = row.temperature;
+  simWorld.humidity = row.humidity;
+  simWorld.gasLevel = row.gasLevel;
+  simWorld.distance = row.distance;
+  simWorld.pitch = row.pitch;
+  simWorld.roll = row.roll;
+
+  // Heading change to the next row, the short way round
+  simWorld.yawRate = 0;
+  if (next && next->ms > row.ms) {
+    float turn = fmod(next->yaw - row.yaw + 540.0f, 360.0f) - 180.0f;
+    simWorld.yawRate = turn * 1000.0f / (next->ms - row.ms);
+  }
+}
+
+// TaskId order, as in telemetry_protocol.py
+static const char *const taskNames[] = {
+    "ir",     "serial_rx", "cloud",  "ranging", "imu",       "gas",
+    "state",  "sensors",   "alerts", "rates",   "history",   "uplink",
+    "live",   "display",   "lcd_flush", "outputs", "heartbeat"};
+static_assert(sizeof(taskNames) / sizeof(taskNames[0]) == TASK_COUNT,
+              "one name per TaskId");
+
+// Tasks that started later than period + deadline
+static void printMisses() {
+  printf("  deadline misses");
+  bool any = false;
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    if (tasks[i].missed) {
+      printf(" %s %u", taskNames[i], tasks[i].missed);
+      any = true;
+    }
+  }
+  printf("%s\n", any ? "" : " none");
+}
+
+static int replay(const char *path) {
+  std::vector<TraceRow> rows;
+  if (!loadTrace(path, rows)) {
+    return 1;
+  }
+
+  double wallStart = wallSeconds();
+  applyTraceRow(rows[0], rows.size() > 1 ? &rows[1] : NULL);
+  bootSketch();
+  uint64_t base = simMicros();
+
+  for (size_t i = 0; i < rows.size(); i++) {
+    const TraceRow *next = i + 1 < rows.size() ? &rows[i + 1] : NULL;
+    applyTraceRow(rows[i], next);
+    // The last row holds for one uplink period
+    unsigned long endMs =
+        next ? next->ms : rows[i].ms + UPDATE_INTERVAL;
+    runUntil(base + (uint64_t)(endMs - rows[0].ms) * 1000);
+  }
+  double wall = wallSeconds() - wallStart;
+
+  printf("replay: %zu trace rows, %.1f s simulated in %.3f s wall "
+         "(%.0fx real time)\n",
+         rows.size(), simSeconds(), wall, simSeconds() / wall);
+  printf("  loop passes   %12lu  %12.0f /s\n", run.passes, run.passes / wall);
+  printf("  samples sent  %12lu  %12.0f /s\n", bridge.samples,
+         bridge.samples / wall);
+  printf("  sample bytes  %12lu  %12.1f per sample\n", bridge.sampleBytes,
+         bridge.samples ? (double)bridge.sampleBytes / bridge.samples : 0.0);
+  printf("  downlink lines%12lu\n", bridge.downlinkLines);
+  printf("  text lines    %12lu, frames %lu\n", bridge.lines, bridge.frames);
+  printf("  state changes %12lu, hazards shown %lu\n", run.stateChanges,
+         run.hazardsShown);
+  printMisses();
+  return 0;
+}
+
+// ==========================================
+// BENCHMARKS
+// ==========================================
+
+static volatile long benchSink; // Keeps results live
+
+static void report(const char *name, unsigned long count, const char *unit,
+                   double seconds) {
+  printf("  %-22s %10lu %-8s %8.3f s  %12.0f /s  %8.1f ns each\n", name,
+         count, unit, seconds, count / seconds, seconds * 1e9 / count);
+}
+
+// Scenes that walk the state machine and every hazard rule (tenths)
+static const SensorData benchScenes[] = {
+    {220, 450, 120, 150, 10, -20, 900}, // Normal
+    {315, 400, 150, 150, 0, 0, 900},    // Fire
+    {180, 600, 110, 150, 0, 0, 900},    // Blizzard
+    {240, 995, 130, 150, 0, 0, 900},    // Hurricane
+    {230, 500, 650, 150, 0, 0, 900},    // Gas -> ALERT
+    {230, 500, 140, 12, 0, 0, 900},     // Obstacle
+    {230, 500, 140, 150, 350, 0, 900},  // Tilt
+    {SENSOR_ERROR_TENTHS, SENSOR_ERROR_TENTHS, 140, -1, 0, 0,
+     900}, // Failed reads
+};
+#define BENCH_SCENE_COUNT (sizeof(benchScenes) / sizeof(benchScenes[0]))
+
+// Quantisation + hazard rules + state transition and actions, per
+// uplink sample
+static void benchStateMachine(unsigned long count) {
+  setState(STATE_ACTIVE);
+  runStateActions();
+  double start = wallSeconds();
+  for (unsigned long i = 0; i < count; i++) {
+    SensorData data = benchScenes[(i / 4) % BENCH_SCENE_COUNT];
+    QuantizedSample sample;
+    quantizeSample(data, currentState, sample);
+    benchSink += evaluateHazards(sample);
+    updateState(stateHazardActive());
+    runStateActions();
+  }
+  report("state machine+alerts", count, "samples", wallSeconds() - start);
+
+  setState(STATE_OFF); // Leave the sketch as it boots
+  runStateActions();
+  resetHazards();
+}
+
+// feedDownlink() over a mix of data and keyword lines
+static void benchDownlinkParser(unsigned long count) {
+  static const char *const lines[] = {
+      "23.4|51.0|312|87|1|-2.3|4.1|181.7\r\n",
+      "31.0|40.5|145|150|2|0.0|0.0|90.0\r\n",
+      "|||||||\r\n",
+      "CLOUD_OK\r\n",
+      "-12.125|99.75|1023|-1|4|-179.9|179.9|359.9\r\n",
+      "STATS\r\n",
+  };
+  const unsigned lineCount = sizeof(lines) / sizeof(lines[0]);
+  std::string stream;
+  for (unsigned i = 0; i < lineCount; i++) {
+    stream += lines[i];
+  }
+
+  DownlinkParser parser;
+  resetDownlinkLine(parser);
+  QuantizedSample data = {};
+  unsigned long events = 0;
+  unsigned long passes = count / lineCount + 1;
+
+  double start = wallSeconds();
+  for (unsigned long pass = 0; pass < passes; pass++) {
+    for (char c : stream) {
+      switch (feedDownlink(parser, c)) {
+      case DOWNLINK_DATA:
+        storeDownlinkData(parser, data);
+        events++;
+        break;
+      case DOWNLINK_KEYWORD:
+        events++;
+        break;
+      }
+    }
+  }
+  double seconds = wallSeconds() - start;
+  benchSink += data.field[FIELD_GAS];
+  report("downlink parser", events, "lines", seconds);
+  printf("  %-22s %10.1f MB/s\n", "",
+         passes * stream.size() / seconds / 1e6);
+}
+
+// The whole sketch over a synthetic hour, hazards every few minutes
+static void benchLoop() {
+  const unsigned long stepMs = UPDATE_INTERVAL;
+  const unsigned long steps = 3600000UL / stepMs;
+
+  double start = wallSeconds();
+  bootSketch();
+  for (unsigned long i = 0; i < steps; i++) {
+    const SensorData &scene = benchScenes[(i / 90) % BENCH_SCENE_COUNT];
+    bool failed = scene.temperature == SENSOR_ERROR_TENTHS;
+    simWorld.temperature = failed ? NAN : scene.temperature / 10.0f;
+    simWorld.humidity = failed ? NAN : scene.humidity / 10.0f;
+    simWorld.gasLevel = scene.gasLevel;
+    simWorld.distance = scene.distance;
+    simWorld.pitch = scene.pitch / 10.0f;
+    simWorld.roll = scene.roll / 10.0f;
+    simWorld.yawRate = 3.0f;
+    runUntil(simMicros() + stepMs * 1000UL);
+  }
+  double seconds = wallSeconds() - start;
+  report("full loop (1 h sim)", run.passes, "passes", seconds);
+  report("", bridge.samples, "samples", seconds);
+  printf("  %-22s %10.0fx real time\n", "", simSeconds() / seconds);
+  printMisses();
+}
+
+static int bench(unsigned long count) {
+  printf("bench: %lu iterations\n", count);
+  benchStateMachine(count);
+  benchDownlinkParser(count);
+  benchLoop();
+  return 0;
+}
+
+// ==========================================
+// MAIN
+// ==========================================
+
+static int usage() {
+  fprintf(stderr,
+          "usage: uav_sim [-v] [-c loop_cost_us] replay TRACE.csv\n"
+          "       uav_sim [-n count] bench\n");
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  unsigned long count = SIM_DEFAULT_BENCH_COUNT;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    if (strcmp(argv[arg], "-v") == 0) {
+      verbose = true;
+    } else if (strcmp(argv[arg], "-c") == 0 && arg + 1 < argc) {
+      loopCostUs = strtoul(argv[++arg], NULL, 10);
+    } else if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc) {
+      count = strtoul(argv[++arg], NULL, 10);
+    } else {
+      return usage();
+    }
+  }
+  if (loopCostUs == 0 || count == 0) {
+    return usage();
+  }
+
+  if (arg + 2 == argc && strcmp(argv[arg], "replay") == 0) {
+    return replay(argv[arg + 1]);
+  }
+  if (arg + 1 == argc && strcmp(argv[arg], "bench") == 0) {
+    return bench(count);
+  }
+  return usage();
+}
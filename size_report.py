@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+===================================================
+Size Report - Disaster Recon UAV
+===================================================
+
+Splits the sketch's SRAM and flash use by module, from the compiled
+ELF. The sketch is one translation unit, so avr-size only gives the
+totals; the debug info still says which file each symbol came from:
+
+    avr-nm -S -l UAV_Telemetry_Proto.ino.elf --> symbol, size, file:line
+                                              --> summed per file
+
+- RAM is .data + .bss (what sits below the heap at boot). What is
+  left over is shared by the heap and the stack; memory.h measures
+  how much of it the stack actually takes (STATS_MEMORY)
+- Flash is code, PROGMEM tables and the .data initialisers
+
+Symbols without debug info (the Arduino core's assembly, libgcc) are
+grouped as "(no file)".
+
+Get the ELF with (Arduino IDE: Sketch > Export Compiled Binary):
+    arduino-cli compile -b arduino:avr:uno --output-dir build .
+
+Usage:
+    python3 size_report.py build/UAV_Telemetry_Proto.ino.elf
+    python3 size_report.py build/UAV_Telemetry_Proto.ino.elf --top 15
+    python3 size_report.py sim/uav_sim --nm nm --ram 0 --flash 0
+===================================================
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+from collections import defaultdict
+
+# ===================================================
+# CONFIGURATION
+# ===================================================
+
+UNO_RAM = 2048  # bytes of SRAM on the ATmega328P
+UNO_FLASH = 32256  # bytes of flash left by the Optiboot bootloader
+AVR_RAM_BASE = 0x800000  # Data space addresses in an AVR ELF
+
+RAM_TYPES = set('bBdDgGsS')  # nm types of .bss/.data symbols
+DATA_TYPES = set('dDgG')  # Initialised: in RAM, and copied from flash
+
+# ===================================================
+# SYMBOLS
+# ===================================================
+
+def read_symbols(elf, nm):
+    """(name, size, type, file) per sized symbol in the ELF"""
+    try:
+        output = subprocess.run(
+            [nm, '-C', '-S', '-l', '--size-sort', elf],
+            check=True, capture_output=True, text=True).stdout
+    except FileNotFoundError:
+        sys.exit(f"✗ {nm} not found (it comes with the Arduino AVR toolchain, or pass --nm)")
+    except subprocess.CalledProcessError as error:
+        sys.exit(f"✗ {nm} failed: {error.stderr.strip()}")
+
+    symbols = []
+    for line in output.splitlines():
+        symbol, _, location = line.partition('\t')
+        parts = symbol.split(None, 3)
+        if len(parts) < 4:
+            continue
+        address, size, kind, name = parts
+        path = location.rpartition(':')[0]
+        symbols.append((name, int(size, 16), kind, int(address, 16), path))
+    return symbols
+
+def is_ram(kind, address):
+    return kind in RAM_TYPES or address >= AVR_RAM_BASE
+
+def module_name(path):
+    return os.path.basename(path) if path else "(no file)"
+
+# ===================================================
+# REPORT
+# ===================================================
+
+def percent(used, budget):
+    return f" ({100 * used / budget:.0f}% of {budget})" if budget else ""
+
+def report(symbols, ram_budget, flash_budget, top):
+    modules = defaultdict(lambda: {'data': 0, 'bss': 0, 'flash': 0})
+    for name, size, kind, address, path in symbols:
+        module = modules[module_name(path)]
+        if not is_ram(kind, address):
+            module['flash'] += size
+        elif kind in DATA_TYPES:
+            module['data'] += size
+            module['flash'] += size  # The initialiser
+        else:
+            module['bss'] += size
+
+    print(f"{'module':28} {'data':>6} {'bss':>6} {'RAM':>6} {'flash':>7}")
+    print("-" * 57)
+    rows = sorted(modules.items(), key=lambda item: (-(item[1]['data'] + item[1]['bss']), -item[1]['flash']))
+    for name, sizes in rows:
+        ram = sizes['data'] + sizes['bss']
+        print(f"{name:28} {sizes['data']:6} {sizes['bss']:6} {ram:6} {sizes['flash']:7}")
+    print("-" * 57)
+
+    ram = sum(sizes['data'] + sizes['bss'] for sizes in modules.values())
+    flash = sum(sizes['flash'] for sizes in modules.values())
+    print(f"static RAM {ram} bytes{percent(ram, ram_budget)}", end="")
+    print(f", {ram_budget - ram} left for heap and stack" if ram_budget else "")
+    print(f"flash      {flash} bytes{percent(flash, flash_budget)}")
+    print("(sized symbols only: avr-size also counts padding and vectors)")
+
+    if top:
+        print()
+        print("Largest RAM symbols:")
+        ram_symbols = [symbol for symbol in symbols if is_ram(symbol[2], symbol[3])]
+        for name, size, kind, address, path in sorted(ram_symbols, key=lambda s: -s[1])[:top]:
+            print(f"  {size:5}  {name:40} {module_name(path)}")
+
+# ===================================================
+# MAIN PROGRAM
+# ===================================================
+
+def main():
+    parser = argparse.ArgumentParser(description="SRAM and flash use per module, from the sketch's ELF")
+    parser.add_argument('elf', help="compiled sketch (.elf, with debug info)")
+    parser.add_argument('--nm', default='avr-nm', help="nm to use (default avr-nm)")
+    parser.add_argument('--ram', type=int, default=UNO_RAM, help=f"SRAM budget in bytes, 0 = none (default {UNO_RAM})")
+    parser.add_argument('--flash', type=int, default=UNO_FLASH, help=f"flash budget in bytes, 0 = none (default {UNO_FLASH})")
+    parser.add_argument('--top', type=int, default=0, help="also list the N largest RAM symbols")
+    args = parser.parse_args()
+
+    report(read_symbols(args.elf, args.nm), args.ram, args.flash, args.top)
+
+# ===================================================
+# ENTRY POINT
+# ===================================================
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+===================================================
+Sample Spool - Disaster Recon UAV
+===================================================
+
+Durable store between the serial reader and the uploader, so samples
+survive cloud outages and bridge restarts:
+1. Every parsed sample is appended here before anything else
+2. The uploader drains the oldest samples in bulk batches
+3. Samples are only deleted once the batch holding them succeeds
+
+Each device (airframe, see fleet_gateway.py) has its own queue in the
+one file, so a channel that keeps failing doesn't hold up the others.
+The single-UAV bridge only uses DEFAULT_DEVICE.
+
+SQLite in WAL mode: appends don't wait for the drainer, each commit is
+a sequential write to the log, and reopening counts what's left. Each
+queue is bounded; on overflow its oldest samples are dropped.
+===================================================
+"""
+
+import json
+import sqlite3
+import threading
+
+DEFAULT_DEVICE = 0
+
+# ===================================================
+# SPOOL
+# ===================================================
+
+class Spool:
+    """Append-only sample log, one queue per device"""
+
+    def __init__(self, path, max_samples):
+        self.max_samples = max_samples  # Per device
+        self.lock = threading.Lock()  # One connection shared by the stages
+        self.dropped = 0
+
+        self.db = sqlite3.connect(path, check_same_thread=False)
+        self.db.execute("PRAGMA journal_mode=WAL")
+        self.db.execute("PRAGMA synchronous=NORMAL")  # Durable at checkpoints, no fsync per sample
+        self.db.execute(
+            "CREATE TABLE IF NOT EXISTS samples ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT, time REAL NOT NULL, data TEXT NOT NULL, "
+            "device INTEGER NOT NULL DEFAULT 0)")
+        columns = [row[1] for row in self.db.execute("PRAGMA table_info(samples)")]
+        if 'device' not in columns:
+            # Spool from before the fleet gateway: everything is the default device
+            self.db.execute("ALTER TABLE samples ADD COLUMN device INTEGER NOT NULL DEFAULT 0")
+        self.db.execute("CREATE INDEX IF NOT EXISTS samples_device ON samples (device, id)")
+        self.db.commit()
+
+        # Uploaded samples are deleted, so whatever is left is pending
+        self.counts = dict(self.db.execute(
+            "SELECT device, COUNT(*) FROM samples GROUP BY device").fetchall())
+
+    def append(self, sample_time, data, device=DEFAULT_DEVICE):
+        """Store one sample; returns its id"""
+        with self.lock:
+            cursor = self.db.execute(
+                "INSERT INTO samples (time, data, device) VALUES (?, ?, ?)",
+                (sample_time, json.dumps(data), device))
+            count = self.counts.get(device, 0) + 1
+
+            if count > self.max_samples:
+                # Outage longer than the spool: give up on the oldest samples
+                excess = count - self.max_samples
+                self.db.execute(
+                    "DELETE FROM samples WHERE id IN "
+                    "(SELECT id FROM samples WHERE device = ? ORDER BY id LIMIT ?)",
+                    (device, excess))
+                self.dropped += excess
+                count = self.max_samples
+
+            self.counts[device] = count
+            self.db.commit()
+            return cursor.lastrowid
+
+    def pending(self, device=None):
+        """Samples not uploaded yet, for one device or all of them"""
+        with self.lock:
+            if device is None:
+                return sum(self.counts.values())
+            return self.counts.get(device, 0)
+
+    def devices(self):
+        """Devices that have samples waiting"""
+        with self.lock:
+            return [device for device, count in self.counts.items() if count]
+
+    def peek(self, limit, device=DEFAULT_DEVICE):
+        """Oldest pending samples as (id, time, data), without removing them"""
+        with self.lock:
+            rows = self.db.execute(
+                "SELECT id, time, data FROM samples WHERE device = ? ORDER BY id LIMIT ?",
+                (device, limit)).fetchall()
+        return [(row_id, sample_time, json.loads(data)) for row_id, sample_time, data in rows]
+
+    def commit(self, last_id, device=DEFAULT_DEVICE):
+        """Mark everything up to last_id as uploaded"""
+        with self.lock:
+            cursor = self.db.execute(
+                "DELETE FROM samples WHERE device = ? AND id <= ?", (device, last_id))
+            if cursor.rowcount:
+                self.counts[device] = self.counts.get(device, 0) - cursor.rowcount
+                self.db.commit()
+
+    def close(self):
+        with self.lock:
+            self.db.execute("PRAGMA wal_checkpoint(TRUNCATE)")
+            self.db.close()
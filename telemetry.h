@@ -0,0 +1,317 @@
+/*
+ * Binary Telemetry for Disaster Recon UAV
+ *
+ * Compact alternative to the CSV line (enable with TELEMETRY_BINARY):
+ * one FRAME_TELEMETRY frame (see frame.h) per uplink, with the
+ * readings as little-endian fixed-point integers.
+ *
+ * With TELEMETRY_DELTA as well, only every TELEMETRY_KEYFRAME_INTERVAL
+ * sample goes out as that full frame (the keyframe). The ones between
+ * are FRAME_TELEMETRY_DELTA frames carrying just the fields that moved
+ * past their deadband, as zigzag varint deltas; the bridge rebuilds
+ * the full records (telemetry_protocol.py).
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "config.h"
+#include "frame.h"
+#include "sensors.h" // For SensorData type
+#include <Arduino.h>
+
+// Telemetry payload (15 bytes):
+//   int16  temperature  0.1 °C   (-9990 = read error)
+//   uint8  humidity     0.5 %    (0xFF = read error)
+//   uint16 gas | state<<12       gas 0-1023, state 0-4
+//   int16  distance     cm       (-1 = out of range)
+//   int16  pitch, roll, yaw  0.1 °
+//   uint8  device       DEVICE_ID (absent in the older 13-byte payload)
+//   uint8  health       healthFlags, bit per SensorId that is down
+//                       (absent in the older 13/14-byte payloads)
+#define TELEMETRY_PAYLOAD_SIZE 15
+#define HUMIDITY_INVALID 0xFF
+#define TEMPERATURE_INVALID -9990
+#define DISTANCE_INVALID -1
+
+// Delta payload (4 bytes + 1-3 per changed field):
+//   uint8  device       DEVICE_ID
+//   uint8  key          seq of the keyframe the deltas build on
+//   uint8  index        1, 2, ... samples since that keyframe
+//   uint8  mask         bit per wire field (below)
+//   varint delta...     zigzag LEB128 of (value - last sent), per bit
+// A gap in index means a lost delta: the bridge waits for a keyframe.
+// The health flags only travel in keyframes, so a change in them
+// sends one straight away.
+
+// Live payload (9 bytes), every LIVE_INTERVAL for the bridge's live
+// dashboard (not uploaded):
+//   uint8  device       DEVICE_ID
+//   int16  pitch, roll, yaw  0.1 °
+//   int16  distance     cm       (-1 = out of range)
+#define LIVE_PAYLOAD_SIZE 9
+
+// ==========================================
+// QUANTISED SAMPLE
+// ==========================================
+// The fixed-point form of SensorData, in the units used on the wire.
+// Shared by the telemetry frames, the alert and rate rules, the
+// window statistics and history ring (packed, below) in history.h and
+// the cloud read-back.
+
+enum SampleField {
+  FIELD_TEMPERATURE, // 0.1 °C
+  FIELD_HUMIDITY,    // 0.5 %
+  FIELD_GAS,         // 0-1023
+  FIELD_DISTANCE,    // cm
+  FIELD_PITCH,       // 0.1 °
+  FIELD_ROLL,        // 0.1 °
+  FIELD_YAW,         // 0.1 °
+  FIELD_COUNT
+};
+
+#define SAMPLE_INVALID INT16_MIN // Sensor error / out of range
+
+struct QuantizedSample {
+  int16_t field[FIELD_COUNT];
+  uint8_t state;
+};
+
+int16_t quantizeTemperature(tenths_t temperature) {
+  return temperature == SENSOR_ERROR_TENTHS ? SAMPLE_INVALID : temperature;
+}
+
+// 0.1 % to 0.5 %, rounded
+int16_t quantizeHumidity(tenths_t humidity) {
+  return (humidity < 0 || humidity > TENTHS(127)) ? SAMPLE_INVALID
+                                                  : (humidity + 2) / 5;
+}
+
+// SensorData is already in tenths; only humidity changes units
+void quantizeSample(const SensorData &data, int state, QuantizedSample &out) {
+  out.field[FIELD_TEMPERATURE] = quantizeTemperature(data.temperature);
+  out.field[FIELD_HUMIDITY] = quantizeHumidity(data.humidity);
+  out.field[FIELD_GAS] = data.gasLevel;
+  out.field[FIELD_DISTANCE] = data.distance < 0 ? SAMPLE_INVALID : data.distance;
+  out.field[FIELD_PITCH] = data.pitch;
+  out.field[FIELD_ROLL] = data.roll;
+  out.field[FIELD_YAW] = data.yaw;
+  out.state = state;
+}
+
+// ==========================================
+// PACKED SAMPLE
+// ==========================================
+// QuantizedSample in 13 bytes instead of 15, for buffers that hold
+// many: humidity in one byte and the state in the top bits of the gas
+// word, as in the keyframe payload.
+
+#define PACKED_HUMIDITY_INVALID 0xFF
+#define PACKED_GAS_MASK 0x03FF
+#define PACKED_STATE_SHIFT 12
+
+struct PackedSample {
+  int16_t temperature;
+  uint8_t humidity;  // PACKED_HUMIDITY_INVALID = read error
+  uint16_t gasState; // gas | state << PACKED_STATE_SHIFT
+  int16_t distance;
+  int16_t pitch;
+  int16_t roll;
+  int16_t yaw;
+} __attribute__((packed));
+
+static_assert(sizeof(PackedSample) == 13, "PackedSample should be 13 bytes");
+
+void packSample(const QuantizedSample &sample, PackedSample &out) {
+  out.temperature = sample.field[FIELD_TEMPERATURE];
+  out.humidity = sample.field[FIELD_HUMIDITY] == SAMPLE_INVALID
+                     ? PACKED_HUMIDITY_INVALID
+                     : sample.field[FIELD_HUMIDITY];
+  out.gasState = (sample.field[FIELD_GAS] & PACKED_GAS_MASK) |
+                 ((uint16_t)sample.state << PACKED_STATE_SHIFT);
+  out.distance = sample.field[FIELD_DISTANCE];
+  out.pitch = sample.field[FIELD_PITCH];
+  out.roll = sample.field[FIELD_ROLL];
+  out.yaw = sample.field[FIELD_YAW];
+}
+
+void unpackSample(const PackedSample &packed, QuantizedSample &out) {
+  out.field[FIELD_TEMPERATURE] = packed.temperature;
+  out.field[FIELD_HUMIDITY] = packed.humidity == PACKED_HUMIDITY_INVALID
+                                  ? SAMPLE_INVALID
+                                  : packed.humidity;
+  out.field[FIELD_GAS] = packed.gasState & PACKED_GAS_MASK;
+  out.field[FIELD_DISTANCE] = packed.distance;
+  out.field[FIELD_PITCH] = packed.pitch;
+  out.field[FIELD_ROLL] = packed.roll;
+  out.field[FIELD_YAW] = packed.yaw;
+  out.state = packed.gasState >> PACKED_STATE_SHIFT;
+}
+
+// ==========================================
+// WIRE FIELDS
+// ==========================================
+// The sample as the frames carry it: SampleField order plus the state,
+// with the invalid markers the keyframe uses.
+
+#define WIRE_STATE FIELD_COUNT
+#define WIRE_FIELD_COUNT (FIELD_COUNT + 1)
+
+static_assert(WIRE_FIELD_COUNT <= 8, "The delta mask has one bit per field");
+
+void toWireFields(const QuantizedSample &sample, int16_t wire[WIRE_FIELD_COUNT]) {
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    wire[i] = sample.field[i];
+  }
+  if (wire[FIELD_TEMPERATURE] == SAMPLE_INVALID) {
+    wire[FIELD_TEMPERATURE] = TEMPERATURE_INVALID;
+  }
+  if (wire[FIELD_HUMIDITY] == SAMPLE_INVALID) {
+    wire[FIELD_HUMIDITY] = HUMIDITY_INVALID;
+  }
+  if (wire[FIELD_DISTANCE] == SAMPLE_INVALID) {
+    wire[FIELD_DISTANCE] = DISTANCE_INVALID;
+  }
+  wire[WIRE_STATE] = sample.state;
+}
+
+bool isInvalidWire(uint8_t field, int16_t value) {
+  switch (field) {
+  case FIELD_TEMPERATURE:
+    return value == TEMPERATURE_INVALID;
+  case FIELD_HUMIDITY:
+    return value == HUMIDITY_INVALID;
+  case FIELD_DISTANCE:
+    return value == DISTANCE_INVALID;
+  }
+  return false;
+}
+
+// ==========================================
+// TELEMETRY FRAME (keyframe)
+// ==========================================
+
+// The sample part of a keyframe (also used by the history frames)
+void frameWireSample(FrameWriter &frame, const int16_t wire[WIRE_FIELD_COUNT]) {
+  frameI16(frame, wire[FIELD_TEMPERATURE]);
+  frameU8(frame, wire[FIELD_HUMIDITY]);
+  frameU16(frame, (wire[FIELD_GAS] & 0x03FF) | ((uint16_t)wire[WIRE_STATE] << 12));
+  frameI16(frame, wire[FIELD_DISTANCE]);
+  frameI16(frame, wire[FIELD_PITCH]);
+  frameI16(frame, wire[FIELD_ROLL]);
+  frameI16(frame, wire[FIELD_YAW]);
+}
+
+void sendWireFrame(const int16_t wire[WIRE_FIELD_COUNT]) {
+  FrameWriter frame;
+  frameBegin(frame, FRAME_TELEMETRY);
+  frameWireSample(frame, wire);
+  frameU8(frame, DEVICE_ID);
+  frameU8(frame, healthFlags);
+
+  frameSend(frame);
+}
+
+void sendTelemetryFrame(const QuantizedSample &sample) {
+  int16_t wire[WIRE_FIELD_COUNT];
+  toWireFields(sample, wire);
+  sendWireFrame(wire);
+}
+
+// ==========================================
+// DELTA FRAMES
+// ==========================================
+
+// Per wire field
+const uint8_t deltaDeadband[WIRE_FIELD_COUNT] PROGMEM = {
+    DEADBAND_TEMPERATURE, DEADBAND_HUMIDITY, DEADBAND_GAS, DEADBAND_DISTANCE,
+    DEADBAND_ATTITUDE,    DEADBAND_ATTITUDE, DEADBAND_ATTITUDE,
+    0, // State: every change
+};
+
+struct DeltaEncoder {
+  int16_t sent[WIRE_FIELD_COUNT]; // What the bridge holds for each field
+  uint8_t key;                    // seq of the last keyframe
+  uint8_t index;                  // Samples since it (0 = keyframe due)
+  uint8_t health;                 // healthFlags in that keyframe
+};
+
+DeltaEncoder deltaEncoder = {{0}, 0, 0, 0};
+
+// Zigzag LEB128: small deltas of either sign take one byte. The
+// difference wraps mod 2^16 and the bridge adds it back the same way.
+void frameVarint(FrameWriter &frame, int16_t delta) {
+  uint16_t zigzag = ((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15);
+  while (zigzag >= 0x80) {
+    frameU8(frame, (zigzag & 0x7F) | 0x80);
+    zigzag >>= 7;
+  }
+  frameU8(frame, zigzag);
+}
+
+// Keyframe every TELEMETRY_KEYFRAME_INTERVAL samples (or on a health
+// change), deltas in between
+void sendDeltaTelemetry(const QuantizedSample &sample) {
+  DeltaEncoder &encoder = deltaEncoder;
+  int16_t wire[WIRE_FIELD_COUNT];
+  toWireFields(sample, wire);
+
+  if (encoder.index == 0 || encoder.health != healthFlags) {
+    encoder.key = frameSequence; // The seq frameBegin() is about to use
+    encoder.health = healthFlags;
+    sendWireFrame(wire);
+    memcpy(encoder.sent, wire, sizeof(wire));
+    encoder.index = 1;
+    return;
+  }
+
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < WIRE_FIELD_COUNT; i++) {
+    int16_t change = wire[i] - encoder.sent[i];
+    bool invalidSwap = isInvalidWire(i, wire[i]) != isInvalidWire(i, encoder.sent[i]);
+    if (change != 0 &&
+        (invalidSwap || abs(change) > pgm_read_byte(&deltaDeadband[i]))) {
+      mask |= 1 << i;
+    }
+  }
+
+  FrameWriter frame;
+  frameBegin(frame, FRAME_TELEMETRY_DELTA);
+  frameU8(frame, DEVICE_ID);
+  frameU8(frame, encoder.key);
+  frameU8(frame, encoder.index);
+  frameU8(frame, mask);
+  for (uint8_t i = 0; i < WIRE_FIELD_COUNT; i++) {
+    if (mask & (1 << i)) {
+      frameVarint(frame, wire[i] - encoder.sent[i]);
+      encoder.sent[i] = wire[i];
+    }
+  }
+  frameSend(frame);
+
+  if (++encoder.index >= TELEMETRY_KEYFRAME_INTERVAL) {
+    encoder.index = 0;
+  }
+}
+
+// ==========================================
+// LIVE FRAME
+// ==========================================
+
+// Skipped while the TX buffer is busy: the next one is LIVE_INTERVAL away
+void sendLiveFrame(const SensorData &data) {
+  if (!frameRoom(LIVE_PAYLOAD_SIZE)) {
+    return;
+  }
+
+  FrameWriter frame;
+  frameBegin(frame, FRAME_LIVE);
+  frameU8(frame, DEVICE_ID);
+  frameI16(frame, data.pitch);
+  frameI16(frame, data.roll);
+  frameI16(frame, data.yaw);
+  frameI16(frame, data.distance < 0 ? DISTANCE_INVALID : data.distance);
+  frameSend(frame);
+}
+
+#endif // TELEMETRY_H
@@ -0,0 +1,515 @@
+#!/usr/bin/env python3
+"""
+===================================================
+Telemetry Protocol - Disaster Recon UAV
+===================================================
+
+Decodes what the Arduino sends over serial:
+1. Plain text lines (CSV telemetry, LIVE: and WINDOW: lines, debug prints)
+2. Binary frames from frame.h: telemetry (TELEMETRY_BINARY = 1, as
+   keyframes and deltas with TELEMETRY_DELTA = 1), live attitude and
+   distance, window statistics, the history ring, log messages
+   (LOG_FRAMES = 1) and profiler stats
+
+Both telemetry forms carry the sensor health flags (health.h): a bit
+per SENSOR_NAMES entry that the sketch has marked down.
+
+Frame layout (must match frame.h):
+    0xA5 | ver<<4|type | seq | len | payload[len] | crc16 (LE)
+
+CRC16 is CRC-16/XMODEM over ver/type..payload.
+===================================================
+"""
+
+import binascii
+import struct
+
+# ===================================================
+# FRAME CONSTANTS (mirror frame.h)
+# ===================================================
+
+FRAME_SYNC = 0xA5
+FRAME_VERSION = 1
+FRAME_HEADER_SIZE = 4
+FRAME_CRC_SIZE = 2
+FRAME_MAX_PAYLOAD = 58
+
+FRAME_TELEMETRY = 0x1
+FRAME_WINDOW = 0x2
+FRAME_LOG = 0x3
+FRAME_STATS = 0x4
+FRAME_TELEMETRY_DELTA = 0x5
+FRAME_LIVE = 0x6
+FRAME_HISTORY = 0x7
+
+# temp, humid, gas|state, dist, pitch, roll, yaw[, device[, health]]
+TELEMETRY_STRUCT = struct.Struct('<hBHhhhh')
+TELEMETRY_DEVICE_STRUCT = struct.Struct('<hBHhhhhB')  # Sketches with DEVICE_ID
+TELEMETRY_HEALTH_STRUCT = struct.Struct('<hBHhhhhBB')  # And health flags
+HUMIDITY_INVALID = 0xFF
+SENSOR_ERROR = -999  # Same sentinel the sketch prints in CSV mode
+
+# Delta frames (telemetry.h): device, key seq, index, field mask, then a
+# zigzag varint per set bit. Wire fields are in SampleField order + state.
+DELTA_HEADER_STRUCT = struct.Struct('<BBBB')
+WIRE_FIELD_COUNT = 8
+
+# Live frames (telemetry.h): device, pitch, roll, yaw, distance. For the
+# dashboard only, between the full samples.
+LIVE_STRUCT = struct.Struct('<Bhhhh')
+LIVE_FIELDS = ['pitch', 'roll', 'yaw', 'distance']
+
+# History frames (history.h): age of the first sample (0 = newest),
+# samples in the ring, then samples in the TELEMETRY_STRUCT layout
+HISTORY_HEADER_STRUCT = struct.Struct('<BB')
+STATE_ALERT = 3  # UAVState in config.h; the bridge asks for the history then
+
+# Window statistics: sample count, then min/max/mean/std dev per field
+WINDOW_HEADER_STRUCT = struct.Struct('<B')
+WINDOW_FIELD_STRUCT = struct.Struct('<hhhH')
+SAMPLE_INVALID = -32768
+
+# (name, scale) per field in the SampleField order of telemetry.h
+WINDOW_FIELDS = [
+    ('temperature', 0.1),
+    ('humidity', 0.5),
+    ('gas_level', 1),
+    ('distance', 1),
+    ('pitch', 0.1),
+    ('roll', 0.1),
+    ('yaw', 0.1),
+]
+
+# Log frames (log.h): level<<4|tag, flags, [int32 value], text
+LOG_LEVELS = ['NONE', 'ERROR', 'WARN', 'INFO', 'DEBUG']
+LOG_TAGS = ['SYS', 'IR', 'SENSOR', 'MOTOR', 'STATE', 'LINK']
+LOG_HAS_VALUE = 0x01
+LOG_VALUE_HEX = 0x02
+LOG_VALUE_STRUCT = struct.Struct('<i')
+
+# Profiler stats (profile.h)
+PROFILE_SECTIONS = ['ir', 'dht', 'gas', 'ranging', 'imu', 'alerts', 'lcd', 'uplink']
+# Scheduler tasks in TaskId order (UAV_Telemetry_Proto.ino)
+TASK_NAMES = ['ir', 'serial_rx', 'cloud', 'ranging', 'imu', 'gas', 'state', 'sensors', 'alerts',
+              'rates', 'history', 'uplink', 'live', 'display', 'lcd_flush', 'outputs', 'heartbeat']
+STATS_SECTIONS = 0
+STATS_LOOP = 1
+STATS_MEMORY = 2
+STATS_HEALTH = 3
+STATS_TASKS = 4
+SECTION_STATS_STRUCT = struct.Struct('<HHHH')  # count, min, max, avg (us)
+MEMORY_STATS_STRUCT = struct.Struct('<HHHHH')  # bytes: RAM, static, heap, free, least free
+SENSOR_STATS_STRUCT = struct.Struct('<HH')  # reads, failures
+HEALTH_STATS_STRUCT = struct.Struct('<BHHBB')  # flags, I2C recoveries, IMU overflows, watchdog timeouts, last task
+
+# Sensors with health tracking, in SensorId order (health.h)
+SENSOR_NAMES = ['dht', 'mpu', 'ranging']
+WATCHDOG_NO_TASK = 0xFF
+
+MAX_TEXT_LINE = 256  # Give up on a text line that never ends
+
+# ===================================================
+# DECODERS
+# ===================================================
+
+def crc16(data):
+    """CRC-16/XMODEM, same as _crc_xmodem_update() on the AVR"""
+    return binascii.crc_hqx(data, 0)
+
+def format_health(flags):
+    """Health flags as the names of the sensors that are down ('ok' if none)"""
+    down = [name for bit, name in enumerate(SENSOR_NAMES) if flags & (1 << bit)]
+    down += [f"bit{bit}" for bit in range(len(SENSOR_NAMES), 8) if flags & (1 << bit)]
+    return ", ".join(down) if down else 'ok'
+
+def unpack_telemetry(payload):
+    """Telemetry payload to (wire fields, device, health), None if malformed"""
+    health = None
+    if len(payload) == TELEMETRY_HEALTH_STRUCT.size:
+        *fields, device, health = TELEMETRY_HEALTH_STRUCT.unpack(payload)
+    elif len(payload) == TELEMETRY_DEVICE_STRUCT.size:
+        *fields, device = TELEMETRY_DEVICE_STRUCT.unpack(payload)
+    elif len(payload) == TELEMETRY_STRUCT.size:
+        fields, device = TELEMETRY_STRUCT.unpack(payload), None
+    else:
+        return None
+
+    temp, humid, gas_state, dist, pitch, roll, yaw = fields
+    return [temp, humid, gas_state & 0x03FF, dist, pitch, roll, yaw, gas_state >> 12], device, health
+
+def wire_to_data(wire, device, health=None):
+    """Wire fields to the dict parse_csv_data() returns"""
+    temp, humid, gas, dist, pitch, roll, yaw, state = wire
+    data = {
+        'temperature': temp / 10.0,
+        'humidity': SENSOR_ERROR if humid == HUMIDITY_INVALID else humid / 2.0,
+        'gas_level': gas,
+        'distance': dist,
+        'drone_state': state,
+        'pitch': pitch / 10.0,
+        'roll': roll / 10.0,
+        'yaw': yaw / 10.0
+    }
+    if device is not None:
+        data['device'] = device
+    if health is not None:
+        data['health'] = health
+    return data
+
+def decode_telemetry(payload):
+    """Turn a telemetry payload into the dict parse_csv_data() returns"""
+    unpacked = unpack_telemetry(payload)
+    return wire_to_data(*unpacked) if unpacked else None
+
+def decode_live(payload):
+    """Live frame to {pitch, roll, yaw, distance, device}, None if malformed"""
+    if len(payload) != LIVE_STRUCT.size:
+        return None
+    device, pitch, roll, yaw, distance = LIVE_STRUCT.unpack(payload)
+    return {'pitch': pitch / 10.0, 'roll': roll / 10.0, 'yaw': yaw / 10.0,
+            'distance': distance, 'device': device}
+
+def parse_live_line(line):
+    """The LIVE:pitch,roll,yaw,distance,device line of CSV mode, None if malformed"""
+    values = line.partition(':')[2].split(',')
+    if len(values) != len(LIVE_FIELDS) + 1:
+        return None
+    try:
+        data = dict(zip(LIVE_FIELDS, (float(value) for value in values[:3])))
+        data['distance'] = int(values[3])
+        data['device'] = int(values[4])
+    except ValueError:
+        return None
+    return data
+
+def read_varint(payload, offset):
+    """Zigzag LEB128 (frameVarint() in telemetry.h) to (int16, next offset)"""
+    value = 0
+    shift = 0
+    while offset < len(payload) and shift < 21:
+        byte = payload[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return (value >> 1) ^ -(value & 1), offset
+    raise ValueError("truncated varint")
+
+class TelemetryDecoder:
+    """Rebuilds full samples from keyframes and delta frames.
+
+    One stream per device, so several UAVs can share a port. A delta
+    that doesn't follow on from the last one (a lost frame, or a
+    keyframe we never saw) is counted in `lost`, and that device's
+    deltas are dropped until its next keyframe; `broken` counts the
+    streams cut short that way.
+    """
+
+    def __init__(self):
+        self.streams = {}  # device -> [key seq, next index, wire fields, health]
+        self.lost = 0
+        self.broken = 0
+
+    def keyframe(self, seq, payload):
+        unpacked = unpack_telemetry(payload)
+        if unpacked is None:
+            return None
+        wire, device, health = unpacked
+        self.streams[device] = [seq, 1, wire, health]
+        return wire_to_data(wire, device, health)
+
+    def drop(self, device):
+        self.lost += 1
+        if self.streams.pop(device, None) is not None:
+            self.broken += 1
+
+    def delta(self, payload):
+        if len(payload) < DELTA_HEADER_STRUCT.size:
+            self.lost += 1
+            return None
+        device, key, index, mask = DELTA_HEADER_STRUCT.unpack_from(payload, 0)
+        stream = self.streams.get(device)
+        if stream is None or stream[0] != key or stream[1] != index:
+            self.drop(device)
+            return None
+
+        wire = list(stream[2])
+        offset = DELTA_HEADER_STRUCT.size
+        try:
+            for field in range(WIRE_FIELD_COUNT):
+                if mask & (1 << field):
+                    delta, offset = read_varint(payload, offset)
+                    # Same mod 2^16 arithmetic as the sketch
+                    wire[field] = ((wire[field] + delta + 0x8000) & 0xFFFF) - 0x8000
+        except ValueError:
+            self.drop(device)
+            return None
+
+        stream[1] = index + 1
+        stream[2] = wire
+        return wire_to_data(wire, device, stream[3])  # Health changes send a keyframe
+
+def decode_window(payload):
+    """Decode the window statistics sent every WINDOW_SAMPLES samples (history.h)"""
+    expected = WINDOW_HEADER_STRUCT.size + WINDOW_FIELD_STRUCT.size * len(WINDOW_FIELDS)
+    if len(payload) != expected:
+        return None
+
+    (samples,) = WINDOW_HEADER_STRUCT.unpack_from(payload, 0)
+    fields = [WINDOW_FIELD_STRUCT.unpack_from(payload, WINDOW_HEADER_STRUCT.size + i * WINDOW_FIELD_STRUCT.size)
+              for i in range(len(WINDOW_FIELDS))]
+    return window_from_fields(samples, fields)
+
+def decode_history(payload):
+    """History frame to (age of the first sample, samples in the ring,
+    [sample dicts, newest first]), None if malformed"""
+    if len(payload) < HISTORY_HEADER_STRUCT.size:
+        return None
+    samples_bytes = len(payload) - HISTORY_HEADER_STRUCT.size
+    if samples_bytes % TELEMETRY_STRUCT.size:
+        return None
+
+    first, total = HISTORY_HEADER_STRUCT.unpack_from(payload, 0)
+    samples = []
+    for offset in range(HISTORY_HEADER_STRUCT.size, len(payload), TELEMETRY_STRUCT.size):
+        wire, device, health = unpack_telemetry(payload[offset:offset + TELEMETRY_STRUCT.size])
+        samples.append(wire_to_data(wire, device, health))
+    return first, total, samples
+
+def parse_window_line(line):
+    """Decode a WINDOW:count,field,min,max,mean,sd line of CSV mode into
+    (count, field index, (min, max, mean, sd)), None if malformed"""
+    try:
+        values = [int(value) for value in line.partition(':')[2].split(',')]
+    except ValueError:
+        return None
+    if len(values) != 6 or not 0 <= values[1] < len(WINDOW_FIELDS):
+        return None
+    return values[0], values[1], values[2:]
+
+class WindowLines:
+    """Rebuilds a window from its WINDOW: lines, one per field
+
+    add() returns the window once its last field is in. A window with a
+    line missing or from another window is dropped.
+    """
+
+    def __init__(self):
+        self.samples = None
+        self.fields = []
+
+    def add(self, samples, index, stats):
+        if index == 0:
+            self.samples = samples
+            self.fields = []
+        elif samples != self.samples or index != len(self.fields):
+            self.samples = None  # Wait for the next window's first line
+            return None
+        self.fields.append(stats)
+        if len(self.fields) < len(WINDOW_FIELDS):
+            return None
+        self.samples = None
+        return window_from_fields(samples, self.fields)
+
+def window_from_fields(samples, fields):
+    """Window dict from (min, max, mean, sd) per WINDOW_FIELDS entry, in wire units"""
+    window = {'samples': samples}
+    for (name, scale), (low, high, mean, sd) in zip(WINDOW_FIELDS, fields):
+        if mean == SAMPLE_INVALID:
+            window[name] = None  # No valid readings in this window
+            continue
+        window[name] = {
+            'min': low * scale,
+            'max': high * scale,
+            'mean': mean * scale,
+            'sd': sd * scale
+        }
+
+    return window
+
+def format_window(window):
+    """One-line summary of a decoded window"""
+    parts = []
+    for name, _ in WINDOW_FIELDS:
+        stats = window[name]
+        if stats is not None:
+            parts.append(f"{name}={stats['mean']:g} [{stats['min']:g}..{stats['max']:g}] ±{stats['sd']:g}")
+    return f"{window['samples']} samples: " + ", ".join(parts)
+
+def log_level(payload):
+    """Level of a log frame, read without decoding the rest"""
+    return payload[0] >> 4 if payload else 0
+
+def decode_log(payload):
+    """Decode a log frame into (level, tag, text)"""
+    if len(payload) < 2:
+        return None
+
+    level = payload[0] >> 4
+    tag = payload[0] & 0x0F
+    flags = payload[1]
+    offset = 2
+    value = ''
+
+    if flags & LOG_HAS_VALUE:
+        if len(payload) < offset + LOG_VALUE_STRUCT.size:
+            return None
+        (number,) = LOG_VALUE_STRUCT.unpack_from(payload, offset)
+        offset += LOG_VALUE_STRUCT.size
+        value = f"{number & 0xFFFFFFFF:X}" if flags & LOG_VALUE_HEX else str(number)
+
+    level_name = LOG_LEVELS[level] if level < len(LOG_LEVELS) else str(level)
+    tag_name = LOG_TAGS[tag] if tag < len(LOG_TAGS) else str(tag)
+    text = payload[offset:].decode('ascii', 'replace') + value
+    return level_name, tag_name, text
+
+def task_name(index):
+    """TaskId to its name (the number if the sketch has more tasks)"""
+    return TASK_NAMES[index] if index < len(TASK_NAMES) else str(index)
+
+def decode_stats(payload):
+    """Decode one profiler page.
+
+    Returns ('sections', {name: (count, min, max, avg)}),
+    ('loop', [count per log2 bucket]), ('memory', {name: bytes}),
+    ('health', {'sensors': {name: (reads, failures)}, 'flags', 'i2c_recoveries',
+    'imu_overflows', 'watchdog_timeouts', 'watchdog_task'}) or
+    ('tasks', {task name: deadline misses}), None if malformed.
+    """
+    if not payload:
+        return None
+
+    if payload[0] == STATS_SECTIONS and len(payload) >= 2:
+        first = payload[1]
+        sections = {}
+        for offset in range(2, len(payload) - SECTION_STATS_STRUCT.size + 1, SECTION_STATS_STRUCT.size):
+            index = first + (offset - 2) // SECTION_STATS_STRUCT.size
+            name = PROFILE_SECTIONS[index] if index < len(PROFILE_SECTIONS) else str(index)
+            sections[name] = SECTION_STATS_STRUCT.unpack_from(payload, offset)
+        return 'sections', sections
+
+    if payload[0] == STATS_LOOP and len(payload) % 2 == 1:
+        return 'loop', list(struct.unpack_from(f'<{len(payload) // 2}H', payload, 1))
+
+    if payload[0] == STATS_MEMORY and len(payload) == 1 + MEMORY_STATS_STRUCT.size:
+        names = ('ram', 'static', 'heap', 'free', 'min_free')
+        return 'memory', dict(zip(names, MEMORY_STATS_STRUCT.unpack_from(payload, 1)))
+
+    if payload[0] == STATS_HEALTH and len(payload) > HEALTH_STATS_STRUCT.size:
+        sensor_bytes = len(payload) - 1 - HEALTH_STATS_STRUCT.size
+        if sensor_bytes % SENSOR_STATS_STRUCT.size:
+            return None
+        sensors = {}
+        for index in range(sensor_bytes // SENSOR_STATS_STRUCT.size):
+            name = SENSOR_NAMES[index] if index < len(SENSOR_NAMES) else str(index)
+            sensors[name] = SENSOR_STATS_STRUCT.unpack_from(payload, 1 + index * SENSOR_STATS_STRUCT.size)
+        flags, recoveries, overflows, bites, task = HEALTH_STATS_STRUCT.unpack_from(payload, 1 + sensor_bytes)
+        return 'health', {
+            'sensors': sensors,
+            'flags': flags,
+            'i2c_recoveries': recoveries,
+            'imu_overflows': overflows,
+            'watchdog_timeouts': bites,
+            'watchdog_task': None if task == WATCHDOG_NO_TASK else task_name(task)
+        }
+
+    if payload[0] == STATS_TASKS and len(payload) % 2 == 1:
+        misses = struct.unpack_from(f'<{len(payload) // 2}H', payload, 1)
+        return 'tasks', {task_name(index): missed for index, missed in enumerate(misses)}
+
+    return None
+
+def format_loop_histogram(buckets):
+    """Loop period histogram as 'range: count' pairs (bucket b holds < 2^b us)"""
+    parts = []
+    for bucket, count in enumerate(buckets):
+        if count:
+            low = 0 if bucket == 0 else 1 << (bucket - 1)
+            last = bucket == len(buckets) - 1
+            label = f">={low}us" if last else f"<{1 << bucket}us"
+            parts.append(f"{label}:{count}")
+    return ", ".join(parts)
+
+# ===================================================
+# STREAM READER
+# ===================================================
+
+class FrameReader:
+    """Splits the serial byte stream into text lines and binary frames.
+
+    feed() returns a list of ('text', str) and ('frame', type, seq, payload)
+    tuples. Corrupted frames are dropped and counted; gaps in the sequence
+    number are counted as dropped frames.
+    """
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.last_seq = None
+        self.frames_ok = 0
+        self.crc_errors = 0
+        self.dropped = 0
+
+    def feed(self, chunk):
+        self.buffer.extend(chunk)
+        items = []
+
+        while self.buffer:
+            if self.buffer[0] == FRAME_SYNC:
+                result = self._take_frame()
+                if result is None:
+                    break  # Need more bytes
+                if result is not False:
+                    items.append(result)
+                continue
+
+            # Text runs up to the next newline or sync byte
+            end = self.buffer.find(b'\n')
+            sync = self.buffer.find(bytes([FRAME_SYNC]))
+            if sync != -1 and (end == -1 or sync < end):
+                # A frame interrupted the line: flush what we have as text
+                text, self.buffer = self.buffer[:sync], self.buffer[sync:]
+                items.append(('text', text.decode('utf-8', 'replace').strip()))
+                continue
+            if end == -1:
+                if len(self.buffer) > MAX_TEXT_LINE:
+                    self.buffer.clear()
+                break
+
+            line, self.buffer = self.buffer[:end], self.buffer[end + 1:]
+            items.append(('text', line.decode('utf-8', 'replace').strip()))
+
+        return items
+
+    def _take_frame(self):
+        """Returns a frame tuple, None if incomplete, False if rejected"""
+        if len(self.buffer) < FRAME_HEADER_SIZE:
+            return None
+
+        length = self.buffer[3]
+        version = self.buffer[1] >> 4
+        if length > FRAME_MAX_PAYLOAD or version != FRAME_VERSION:
+            del self.buffer[0]  # Not a real frame start, resync
+            return False
+
+        total = FRAME_HEADER_SIZE + length + FRAME_CRC_SIZE
+        if len(self.buffer) < total:
+            return None
+
+        frame = bytes(self.buffer[:total])
+        (crc,) = struct.unpack_from('<H', frame, total - FRAME_CRC_SIZE)
+        if crc16(frame[1:total - FRAME_CRC_SIZE]) != crc:
+            self.crc_errors += 1
+            del self.buffer[0]
+            return False
+
+        del self.buffer[:total]
+        frame_type = frame[1] & 0x0F
+        seq = frame[2]
+        self._track_sequence(seq)
+        self.frames_ok += 1
+        return ('frame', frame_type, seq, frame[FRAME_HEADER_SIZE:total - FRAME_CRC_SIZE])
+
+    def _track_sequence(self, seq):
+        if self.last_seq is not None:
+            self.dropped += (seq - self.last_seq - 1) & 0xFF
+        self.last_seq = seq
@@ -10,9 +10,21 @@ Course: CST2590 - IoT Cloud (Lecture 9)
 This script:
 1. Reads sensor data from Arduino via Serial
 2. Uploads data to ThingSpeak (WRITE)
-3. Waits for data to be available
-4. Reads data back from ThingSpeak (READ)
-5. Sends retrieved data back to Arduino
+3. Keeps the channel's last entry in a cache, updated by its own writes
+4. Reads data back from ThingSpeak (READ) now and then, for changes
+   made by anyone else
+5. Sends the fields that changed back to Arduino
+
+Each step runs as its own pipeline stage so network latency never
+stalls serial ingest:
+
+    serial reader --> spool (SQLite) --> uploader --> channel cache
+         ^                                                 |
+         +---------- serial link <---- downlink poller <---+
+                                            (+ GET every POLL_INTERVAL)
+
+Samples are written to the on-disk spool first, so an outage or a
+restart of this script doesn't lose them (see spool.py).
 
 Date: 2025-12-10
 ===================================================
@@ -20,9 +32,39 @@ Date: 2025-12-10
 
 import serial
 import requests
+import threading
 import time
 import sys
-from datetime import datetime
+from datetime import datetime, timezone
+from requests.adapters import HTTPAdapter
+from urllib3.util.retry import Retry
+
+from telemetry_protocol import (
+    FrameReader,
+    FRAME_TELEMETRY,
+    FRAME_WINDOW,
+    FRAME_LOG,
+    FRAME_STATS,
+    FRAME_TELEMETRY_DELTA,
+    FRAME_LIVE,
+    FRAME_HISTORY,
+    STATE_ALERT,
+    TelemetryDecoder,
+    WindowLines,
+    decode_history,
+    decode_live,
+    decode_log,
+    decode_stats,
+    decode_window,
+    format_health,
+    format_loop_histogram,
+    format_window,
+    log_level,
+    parse_live_line,
+    parse_window_line
+)
+from dashboard import Dashboard
+from spool import Spool
 
 # ===================================================
 # CONFIGURATION
@@ -44,9 +86,32 @@ READ_API_KEY = THINGSPEAK_READ_API_KEY
 
 # Local configuration (not sensitive)
 COM_PORT = 'COM7'
-BAUD_RATE = 9600
-UPDATE_INTERVAL = 20  # seconds (must be >= 15 for ThingSpeak free tier)
-READ_DELAY = 5  # seconds to wait after write before reading
+THINGSPEAK_URL = 'https://api.thingspeak.com'  # bridge_loadtest.py points this at its mock
+BAUD_RATE = 9600  # Boot rate of the sketch, and the fallback
+MAX_BAUD_RATE = 250000  # Highest rate we accept in the handshake (USB-serial limit)
+BAUD_SWITCH_TIMEOUT = 1.0  # seconds to hear BAUD_CHECK at the new rate
+LINK_SILENCE_TIMEOUT = 12  # seconds without valid data before dropping back to BAUD_RATE
+POLL_INTERVAL = 60  # seconds between read-backs (our own writes are echoed from the cache)
+READ_DELAY = 5  # seconds a write takes to show up in reads; no read-back is sooner after one
+
+# Bulk uploads: every sample is kept and sent in batches
+WRITE_RATE = 1 / 15  # requests per second (ThingSpeak free tier: 1 per 15 s)
+WRITE_BURST = 1  # requests that may go back to back after a quiet spell
+BULK_MAX_SAMPLES = 960  # samples per bulk request (free tier limit)
+
+# Pipeline
+SPOOL_PATH = 'uav_spool.db'  # on-disk queue of samples not uploaded yet
+SPOOL_MAX_SAMPLES = 200000  # ~4.5 days at one sample per 2 s (oldest dropped)
+RETRY_BACKOFF = 2  # seconds before the first retry, doubled each time
+MAX_BACKOFF = 120  # seconds, retry delay stops growing here
+HTTP_TIMEOUT = 10  # seconds per request
+SERIAL_TIMEOUT = 0.2  # seconds a serial read may block (keeps shutdown quick)
+SHOW_LOG_LEVEL = 3  # Arduino log frames shown up to: 1 error, 2 warn, 3 info, 4 debug
+STATS_INTERVAL = 60  # seconds between profiler requests (0 = never)
+
+# Live dashboard (dashboard.py): every sample, as it arrives, to a browser
+DASHBOARD_HOST = '127.0.0.1'  # '0.0.0.0' to serve the crew's LAN as well
+DASHBOARD_PORT = 8080  # http://localhost:8080/ (0 = off)
 
 # ===================================================
 # HELPER FUNCTIONS
@@ -60,30 +125,31 @@ def print_header():
     print("=" * 60)
     print(f"ThingSpeak Channel: {CHANNEL_ID}")
     print(f"Serial Port: {COM_PORT} @ {BAUD_RATE} baud")
-    print(f"Update Interval: {UPDATE_INTERVAL} seconds")
+    print(f"Bulk Upload: every {1 / WRITE_RATE:.0f} seconds, up to {BULK_MAX_SAMPLES} samples")
     print("=" * 60)
     print()
 
-def connect_serial():
-    """Establish serial connection to Arduino"""
+def connect_serial(port=None):
+    """Establish serial connection to Arduino (on COM_PORT by default)"""
+    port = port or COM_PORT
     try:
-        ser = serial.Serial(COM_PORT, BAUD_RATE, timeout=2)
+        ser = serial.Serial(port, BAUD_RATE, timeout=SERIAL_TIMEOUT)
         time.sleep(2)  # Wait for Arduino to initialize
-        print(f"✓ Connected to Arduino on {COM_PORT}")
+        print(f"✓ Connected to Arduino on {port}")
         return ser
     except serial.SerialException as e:
-        print(f"✗ Error connecting to {COM_PORT}: {e}")
+        print(f"✗ Error connecting to {port}: {e}")
         print("  Check COM port and ensure Arduino is connected")
         return None
 
 def parse_csv_data(line):
     """Parse CSV data from Arduino"""
     try:
-        # CSV format: temp,humid,gas,dist,state,pitch,roll,yaw
+        # CSV format: temp,humid,gas,dist,state,pitch,roll,yaw[,device[,health]]
         values = line.split(',')
         
-        if len(values) != 8:
-            print(f"✗ Invalid CSV (expected 8 values, got {len(values)}): {line}")
+        if len(values) not in (8, 9, 10):
+            print(f"✗ Invalid CSV (expected 8 to 10 values, got {len(values)}): {line}")
             return None
         
         data = {
@@ -96,45 +162,71 @@ def parse_csv_data(line):
             'roll': float(values[6]),
             'yaw': float(values[7])
         }
+        if len(values) >= 9:
+            data['device'] = int(values[8])  # DEVICE_ID, for the fleet gateway
+        if len(values) == 10:
+            data['health'] = int(values[9])  # Bit per sensor that is down (health.h)
         return data
     except (ValueError, IndexError) as e:
         print(f"✗ Error parsing CSV: {e} - {line}")
         return None
 
-def upload_to_thingspeak(data):
-    """Upload sensor data to ThingSpeak"""
+def make_session(pool_maxsize=4):
+    """HTTP session with pooled keep-alive connections to ThingSpeak"""
+    session = requests.Session()
+    
+    # Only connection failures are retried here: a write that reached the
+    # server must not be replayed blindly. The uploader retries the rest.
+    retry = Retry(total=3, connect=3, read=0, status=0, backoff_factor=0.5)
+    adapter = HTTPAdapter(pool_connections=1, pool_maxsize=pool_maxsize, max_retries=retry)
+    session.mount(THINGSPEAK_URL, adapter)
+    return session
+
+# Sample keys of field1 ... field8
+CHANNEL_FIELDS = ['temperature', 'humidity', 'gas_level', 'distance', 'drone_state', 'pitch', 'roll', 'yaw']
+
+def bulk_update_entry(sample_time, data):
+    """One sample in the bulk-write JSON format"""
+    entry = {"created_at": datetime.fromtimestamp(sample_time, timezone.utc).isoformat()}
+    for number, key in enumerate(CHANNEL_FIELDS, 1):
+        entry[f"field{number}"] = data[key]
+    return entry
+
+def upload_to_thingspeak(session, samples, channel=None):
+    """Upload a batch of (time, data) samples with one bulk-write request.
+    
+    channel is a FLEET_CHANNELS entry; None means this script's channel.
+    """
+    channel_id = channel['channel_id'] if channel else CHANNEL_ID
+    write_api_key = channel['write_api_key'] if channel else WRITE_API_KEY
     try:
-        url = f"https://api.thingspeak.com/update?api_key={WRITE_API_KEY}"
+        url = f"{THINGSPEAK_URL}/channels/{channel_id}/bulk_update.json"
         
-        # Build field parameters
-        params = {
-            "field1": data['temperature'],   # Temperature
-            "field2": data['humidity'],      # Humidity
-            "field3": data['gas_level'],     # Gas Level
-            "field4": data['distance'],      # Distance
-            "field5": data['drone_state'],   # Drone State
-            "field6": data['pitch'],         # Pitch
-            "field7": data['roll'],          # Roll
-            "field8": data['yaw']            # Yaw
+        body = {
+            "write_api_key": write_api_key,
+            "updates": [bulk_update_entry(t, data) for t, data in samples]
         }
         
-        # Send HTTP GET request
-        response = requests.get(url, params=params, timeout=10)
+        # Send HTTP POST request
+        response = session.post(url, json=body, timeout=HTTP_TIMEOUT)
         
-        if response.status_code == 200 and response.text != "0":
-            return True, response.text
+        if response.status_code in (200, 202):
+            return True, f"{len(samples)} samples"
         else:
-            return False, f"Upload failed: {response.text}"
+            return False, f"Upload failed ({response.status_code}): {response.text}"
             
     except requests.exceptions.RequestException as e:
         return False, f"Network error: {e}"
 
-def read_from_thingspeak():
-    """Read latest data from ThingSpeak"""
+def read_from_thingspeak(session, channel=None):
+    """Read latest data from ThingSpeak (channel as for upload_to_thingspeak)"""
+    channel_id = channel['channel_id'] if channel else CHANNEL_ID
+    read_api_key = channel['read_api_key'] if channel else READ_API_KEY
     try:
-        url = f"https://api.thingspeak.com/channels/{CHANNEL_ID}/feeds.json?api_key={READ_API_KEY}&results=1"
+        url = f"{THINGSPEAK_URL}/channels/{channel_id}/feeds.json"
+        params = {"api_key": read_api_key, "results": 1}
         
-        response = requests.get(url, timeout=10)
+        response = session.get(url, params=params, timeout=HTTP_TIMEOUT)
         data = response.json()
         
         if not data.get("feeds") or not data["feeds"]:
@@ -163,16 +255,463 @@ def read_from_thingspeak():
         print(f"   ✗ Error processing ThingSpeak data: {e}")
         return None
 
-def send_to_arduino(ser, data_list):
+# ===================================================
+# PIPELINE STAGES
+# ===================================================
+
+def is_clean_text(line):
+    """True for a readable line (garbage at the wrong baud rate isn't)"""
+    return bool(line) and all(32 <= ord(c) < 127 for c in line)
+
+class SerialLink:
+    """Serial port shared by the stages; writes are serialised"""
+    
+    def __init__(self, ser):
+        self.ser = ser
+        self.write_lock = threading.Lock()
+    
+    def send_line(self, text):
+        try:
+            with self.write_lock:
+                self.ser.write((text + "\r\n").encode('utf-8'))
+            return True
+        except serial.SerialException as e:
+            print(f"   ✗ Error sending to Arduino: {e}")
+            return False
+    
+    def set_baud(self, baud):
+        """Switch rate once everything already written has gone out"""
+        with self.write_lock:
+            self.ser.flush()
+            self.ser.baudrate = baud
+
+def send_to_arduino(link, data_list):
     """Send data to Arduino via serial"""
+    # Format: value1|value2|value3|...|value8\r\n
+    return link.send_line("|".join(data_list))
+
+class ChannelCache:
+    """The channel's last entry as this side knows it.
+    
+    Our own uploads write through it, so they're known without reading
+    them back. The Arduino gets the fields that changed; a full line
+    now and then tells it the others are still current (it marks
+    fields it hasn't heard about for a while as stale).
+    """
+    
+    def __init__(self):
+        self.lock = threading.Lock()  # Uploader and poller both update it
+        self.fields = [None] * len(CHANNEL_FIELDS)  # Strings, as ThingSpeak returns them
+        self.changed = set()  # Field indexes not sent to the Arduino yet
+    
+    def update(self, values):
+        """Merge eight field values (None = unknown); returns how many changed"""
+        with self.lock:
+            for index, value in enumerate(values):
+                if value is not None and not same_value(value, self.fields[index]):
+                    self.fields[index] = str(value)
+                    self.changed.add(index)
+            return len(self.changed)
+    
+    def write_through(self, data):
+        """A sample that has just been uploaded is the channel's last entry"""
+        return self.update([data[key] for key in CHANNEL_FIELDS])
+    
+    def downlink(self, full=False):
+        """Fields for the Arduino ('' = unchanged), None if there's nothing to send"""
+        with self.lock:
+            send = set(range(len(self.fields))) if full else self.changed
+            if not any(self.fields[index] is not None for index in send):
+                return None
+            self.changed = set()
+            return [field if index in send and field is not None else '' for index, field in enumerate(self.fields)]
+
+def same_value(a, b):
+    """Field values compared as numbers where they are ('23.40' == 23.4)"""
+    if a is None or b is None:
+        return a is b
     try:
-        # Format: value1|value2|value3|...|value8\r\n
-        data_string = "|".join(data_list) + "\r\n"
-        ser.write(data_string.encode('utf-8'))
-        return True
-    except Exception as e:
-        print(f"   ✗ Error sending to Arduino: {e}")
-        return False
+        return float(a) == float(b)
+    except ValueError:
+        return str(a) == str(b)
+
+class TokenBucket:
+    """Write rate limiter: rate tokens per second, up to capacity saved up"""
+    
+    def __init__(self, rate, capacity):
+        self.rate = rate
+        self.capacity = capacity
+        self.tokens = capacity
+        self.updated = time.monotonic()
+    
+    def wait_time(self):
+        """Seconds until a token is available (0 = now)"""
+        now = time.monotonic()
+        self.tokens = min(self.capacity, self.tokens + (now - self.updated) * self.rate)
+        self.updated = now
+        return 0 if self.tokens >= 1 else (1 - self.tokens) / self.rate
+    
+    def take(self):
+        self.tokens -= 1
+
+class SerialReader(threading.Thread):
+    """Drains the serial port and appends samples to the spool"""
+    
+    def __init__(self, link, spool, stop, dashboard=None):
+        super().__init__(name="serial-reader", daemon=True)
+        self.link = link
+        self.spool = spool
+        self.stop = stop
+        self.dashboard = dashboard  # Gets every sample as it is decoded
+        self.reader = FrameReader()  # Handles CSV/debug lines and binary frames
+        self.telemetry = TelemetryDecoder()  # Rebuilds samples from delta frames
+        self.window_lines = WindowLines()  # Rebuilds windows from WINDOW: lines
+        self.baud_check_deadline = None  # Set while a rate switch is unconfirmed
+        self.last_valid = time.monotonic()
+        self.last_stats_request = time.monotonic()
+        self.health = {}  # device -> last health flags seen
+        self.states = {}  # device -> last drone state seen
+    
+    def run(self):
+        while not self.stop.is_set():
+            self.check_baud()
+            self.request_stats()
+            
+            try:
+                # Blocks for at most SERIAL_TIMEOUT
+                chunk = self.link.ser.read(self.link.ser.in_waiting or 1)
+            except serial.SerialException as e:
+                print(f"✗ Serial error: {e}")
+                self.stop.set()
+                break
+            
+            for item in self.reader.feed(chunk):
+                if item[0] == 'frame' or is_clean_text(item[1]):
+                    self.last_valid = time.monotonic()
+                self.handle(item)
+    
+    def fall_back(self, reason):
+        print(f"  ⚠️  {reason}, back to {BAUD_RATE} baud")
+        self.baud_check_deadline = None
+        self.link.set_baud(BAUD_RATE)
+        self.last_valid = time.monotonic()
+    
+    def check_baud(self):
+        now = time.monotonic()
+        if self.baud_check_deadline is not None and now > self.baud_check_deadline:
+            # The sketch gives up after the same timeout
+            self.fall_back("No BAUD_CHECK at the new rate")
+        elif self.link.ser.baudrate != BAUD_RATE and now - self.last_valid > LINK_SILENCE_TIMEOUT:
+            # e.g. the Arduino was reset and is back at its boot rate
+            self.fall_back(f"Nothing readable for {LINK_SILENCE_TIMEOUT} seconds")
+    
+    def request_stats(self):
+        now = time.monotonic()
+        if STATS_INTERVAL and now - self.last_stats_request >= STATS_INTERVAL:
+            self.last_stats_request = now
+            self.link.send_line("STATS")
+    
+    def print_stats(self, payload):
+        stats = decode_stats(payload)
+        if stats is None:
+            print("✗ Malformed stats frame")
+        elif stats[0] == 'sections':
+            for name, (count, low, high, avg) in stats[1].items():
+                if count:
+                    print(f"  ⏲  {name:8} n={count:5} min={low}us avg={avg}us max={high}us")
+        elif stats[0] == 'memory':
+            memory = stats[1]
+            if memory['ram']:  # 0 from the host simulation
+                print(f"  ⏲  SRAM: {memory['static']}B static + {memory['heap']}B heap of {memory['ram']}B, "
+                      f"{memory['free']}B free (least {memory['min_free']}B)")
+        elif stats[0] == 'health':
+            health = stats[1]
+            sensors = ", ".join(f"{name} {failures}/{reads} failed"
+                                for name, (reads, failures) in health['sensors'].items())
+            print(f"  ⏲  sensors: {sensors}; down: {format_health(health['flags'])}, "
+                  f"I2C recoveries: {health['i2c_recoveries']}, IMU overflows: {health['imu_overflows']}")
+            if health['watchdog_timeouts']:
+                print(f"  ⚠️  Watchdog timeouts since power-on: {health['watchdog_timeouts']} "
+                      f"(last in task {health['watchdog_task']})")
+        elif stats[0] == 'tasks':
+            late = ", ".join(f"{name} {missed}" for name, missed in stats[1].items() if missed)
+            print(f"  ⏲  deadline misses: {late or 'none'}")
+        else:
+            print(f"  ⏲  loop period: {format_loop_histogram(stats[1])}")
+    
+    def negotiate(self, line):
+        """Answer CONNECT_CLOUD[:max_baud] and switch rate if one was offered"""
+        offer = line.partition(':')[2]
+        if not offer.isdigit():
+            # Older sketch: no handshake, stay where we are
+            self.link.send_line("CLOUD_OK")
+            print("  ☁️  Replied CLOUD_OK")
+            return
+        
+        baud = min(int(offer), MAX_BAUD_RATE)
+        self.link.send_line(f"CLOUD_OK:{baud}")
+        print(f"  ☁️  Replied CLOUD_OK, link rate {baud} baud")
+        if baud != self.link.ser.baudrate:
+            self.link.set_baud(baud)
+            self.baud_check_deadline = time.monotonic() + BAUD_SWITCH_TIMEOUT
+    
+    def handle(self, item):
+        data = None
+        line = None
+        
+        if item[0] == 'frame':
+            _, frame_type, seq, payload = item
+            if frame_type == FRAME_LOG:
+                # Dropped on the level byte alone unless we want to see it
+                if log_level(payload) <= SHOW_LOG_LEVEL:
+                    entry = decode_log(payload)
+                    if entry:
+                        print(f"[Arduino/{entry[1]}] {entry[0]}: {entry[2]}")
+                return
+            if frame_type == FRAME_STATS:
+                self.print_stats(payload)
+                return
+            if frame_type == FRAME_HISTORY:
+                self.print_history(payload)
+                return
+            if frame_type == FRAME_LIVE:
+                live = decode_live(payload)
+                if live:
+                    self.store_live(time.time(), live)
+                    return
+            if frame_type == FRAME_WINDOW:
+                window = decode_window(payload)
+                if window:
+                    print(f"  📊 Window: {format_window(window)}")
+                    return
+            elif frame_type == FRAME_TELEMETRY:
+                data = self.telemetry.keyframe(seq, payload)
+            elif frame_type == FRAME_TELEMETRY_DELTA:
+                broken = self.telemetry.broken
+                data = self.telemetry.delta(payload)
+                if data is None:
+                    if self.telemetry.broken != broken:
+                        print("  ⚠️  Telemetry delta out of sequence, waiting for the next keyframe")
+                    return
+            if data is None:
+                print(f"✗ Unknown frame (type={frame_type}, seq={seq}, {len(payload)} bytes)")
+                return
+        else:
+            line = item[1]
+            
+            if line.startswith("CONNECT_CLOUD"):
+                # The sketch waits for this before it shows cloud data
+                print(f"[Arduino] {line}")
+                self.negotiate(line)
+                return
+            
+            if line == "PING":
+                # Sketch heartbeat while the line has been quiet
+                self.link.send_line("PONG")
+                return
+            
+            if line == "BAUD_CHECK":
+                # Sketch is talking at the new rate: confirm it
+                self.link.send_line("BAUD_OK")
+                self.baud_check_deadline = None
+                print(f"  ✓ Link running at {self.link.ser.baudrate} baud")
+                return
+            
+            if line.startswith("LIVE:"):
+                # Attitude and distance between the samples (CSV mode)
+                live = parse_live_line(line)
+                if live:
+                    self.store_live(time.time(), live)
+                return
+            
+            if line.startswith("WINDOW:"):
+                # Window statistics in CSV mode (history.h)
+                parsed = parse_window_line(line)
+                if parsed is None:
+                    print(f"✗ Malformed window line: {line}")
+                    return
+                window = self.window_lines.add(*parsed)
+                if window:
+                    print(f"  📊 Window: {format_window(window)}")
+                return
+            
+            # Check if it's CSV data (contains numbers and commas)
+            is_csv = ',' in line and not line.startswith('[')
+            if not is_csv:
+                # Print non-CSV lines (debug messages from Arduino)
+                if line.strip():
+                    print(f"[Arduino] {line}")
+                return
+        
+        if data is None:
+            data = parse_csv_data(line)
+        if data is None:
+            return
+        
+        self.check_health(data)
+        self.check_alert(data)
+        # Timestamp on arrival
+        self.store(time.time(), data)
+    
+    def check_health(self, data):
+        """Say when a sensor goes down or comes back"""
+        health = data.get('health')
+        if health is None:
+            return  # Sketch without health.h
+        device = data.get('device')
+        last = self.health.get(device, 0)
+        if health != last:
+            if health & ~last:
+                print(f"  ⚠️  Sensor down: {format_health(health & ~last)}")
+            if last & ~health:
+                print(f"  ✓ Sensor recovered: {format_health(last & ~health)}")
+            self.health[device] = health
+    
+    def check_alert(self, data):
+        """Ask for the samples that led up to an alert"""
+        device = data.get('device')
+        state = data.get('drone_state')
+        if state == STATE_ALERT and self.states.get(device) != STATE_ALERT:
+            self.link.send_line("HISTORY")
+        self.states[device] = state
+    
+    def print_history(self, payload):
+        history = decode_history(payload)
+        if history is None:
+            print("✗ Malformed history frame")
+            return
+        first, total, samples = history
+        if not total:
+            print("  📼 History: empty")
+        for age, data in enumerate(samples, first):
+            print(f"  📼 History {age + 1}/{total}: state={data['drone_state']}, Temp={data['temperature']}°C, "
+                  f"Humid={data['humidity']}%, Gas={data['gas_level']}, Dist={data['distance']}cm, "
+                  f"Pitch={data['pitch']}, Roll={data['roll']}")
+    
+    def store(self, sample_time, data):
+        """Keep a sample for the next bulk upload (the fleet gateway overrides this)"""
+        timestamp = datetime.fromtimestamp(sample_time).strftime("%H:%M:%S")
+        print(f"  [{timestamp}] Temp={data['temperature']}°C, Humid={data['humidity']}%, Gas={data['gas_level']}, Dist={data['distance']}cm", end='\r')
+        
+        self.spool.append(sample_time, data)
+        if self.dashboard:
+            self.dashboard.publish(sample_time, data)
+    
+    def store_live(self, sample_time, data):
+        """Show a live update on the dashboard; it isn't spooled or uploaded"""
+        if self.dashboard:
+            self.dashboard.publish(sample_time, data)
+
+class Uploader(threading.Thread):
+    """Drains the spool in bulk writes paced by a token bucket"""
+    
+    def __init__(self, session, spool, cache, uploaded, stop, link_stats=None):
+        super().__init__(name="uploader", daemon=True)
+        self.session = session
+        self.spool = spool
+        self.cache = cache
+        self.uploaded = uploaded  # Set after each successful write
+        self.stop = stop
+        self.link_stats = link_stats  # FrameReader, for the link summary
+        self.bucket = TokenBucket(WRITE_RATE, WRITE_BURST)
+        self.backoff_until = 0
+        self.backoff = RETRY_BACKOFF
+    
+    def run(self):
+        pending = self.spool.pending()
+        if pending:
+            print(f"  📦 {pending} samples left in the spool from last run")
+        
+        while not self.stop.is_set():
+            delay = max(self.bucket.wait_time(), self.backoff_until - time.monotonic())
+            if delay <= 0 and self.spool.pending():
+                self.flush()
+                continue
+            
+            # Samples keep arriving in the spool meanwhile
+            self.stop.wait(min(max(delay, 0.05), 0.5))
+        
+        pending = self.spool.pending()
+        if pending:
+            print(f"\n  📦 {pending} samples kept in the spool for next run")
+    
+    def flush(self):
+        rows = self.spool.peek(BULK_MAX_SAMPLES)
+        samples = [(sample_time, data) for _, sample_time, data in rows]
+        self.bucket.take()
+        
+        timestamp = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
+        print(f"\n[{timestamp}] === BULK UPLOAD ===")
+        print(f"  📤 UPLOADING {len(samples)} samples to ThingSpeak...")
+        if self.link_stats and (self.link_stats.dropped or self.link_stats.crc_errors):
+            print(f"  ⚠️  Link: {self.link_stats.dropped} frames dropped, {self.link_stats.crc_errors} CRC errors so far")
+        if self.spool.dropped:
+            print(f"  ⚠️  Spool full: {self.spool.dropped} oldest samples dropped so far")
+        
+        success, message = upload_to_thingspeak(self.session, samples)
+        
+        if success:
+            self.spool.commit(rows[-1][0])
+            self.backoff = RETRY_BACKOFF
+            print(f"  ✓ Upload Success ({message}, oldest {time.time() - samples[0][0]:.1f}s old)")
+            self.cache.write_through(samples[-1][1])
+            self.uploaded.set()
+            return
+        
+        # Leave the batch in the spool and try again later, backing off exponentially
+        print(f"  ✗ Upload Failed: {message}")
+        print(f"  ⏳ Retrying in {self.backoff} seconds ({self.spool.pending()} samples spooled)...")
+        self.backoff_until = time.monotonic() + self.backoff
+        self.backoff = min(self.backoff * 2, MAX_BACKOFF)
+
+class DownlinkPoller(threading.Thread):
+    """Forwards channel changes to the Arduino: ours right after each
+    upload (from the cache), anyone else's from a read every POLL_INTERVAL"""
+    
+    def __init__(self, session, link, cache, uploaded, stop):
+        super().__init__(name="downlink-poller", daemon=True)
+        self.session = session
+        self.link = link
+        self.cache = cache
+        self.uploaded = uploaded
+        self.stop = stop
+    
+    def run(self):
+        read_due = time.monotonic() + POLL_INTERVAL
+        while not self.stop.is_set():
+            if self.uploaded.wait(max(read_due - time.monotonic(), 0)):
+                self.uploaded.clear()
+                # A read right now could still return the entry before ours
+                read_due = max(read_due, time.monotonic() + READ_DELAY)
+                if not self.stop.is_set():
+                    self.send(self.cache.downlink(), "cache")
+                continue
+            if self.stop.is_set():
+                break
+            read_due = time.monotonic() + POLL_INTERVAL
+            self.poll()
+    
+    def poll(self):
+        print(f"  📥 READING from ThingSpeak...")
+        retrieved_data = read_from_thingspeak(self.session)
+        
+        if not retrieved_data:
+            print(f"  ✗ Failed to read from ThingSpeak")
+            return
+        
+        changed = self.cache.update(retrieved_data)
+        print(f"  ✓ Read Success: {' | '.join(retrieved_data)} ({changed} fields changed)")
+        self.send(self.cache.downlink(full=True), "channel")
+    
+    def send(self, retrieved_data, source):
+        if not retrieved_data:
+            return  # Nothing changed
+        
+        print(f"  📡 Sending to Arduino (from {source}): {' | '.join(field or '-' for field in retrieved_data)}")
+        if send_to_arduino(self.link, retrieved_data):
+            print(f"  ✓ Sent to Arduino successfully!")
+        else:
+            print(f"  ✗ Failed to send to Arduino")
 
 # ===================================================
 # MAIN PROGRAM
@@ -191,77 +730,50 @@ def main():
     print("  (Make sure UAV is turned ON via IR remote)")
     print()
     
-    last_upload_time = 0
+    link = SerialLink(ser)
+    session = make_session()
+    spool = Spool(SPOOL_PATH, SPOOL_MAX_SAMPLES)
+    cache = ChannelCache()
+    uploaded = threading.Event()
+    stop = threading.Event()
+    
+    dashboard = None
+    if DASHBOARD_PORT:
+        dashboard = Dashboard(DASHBOARD_HOST, DASHBOARD_PORT)
+        if not dashboard.start():
+            dashboard = None
+    
+    reader = SerialReader(link, spool, stop, dashboard)
+    stages = [
+        reader,
+        Uploader(session, spool, cache, uploaded, stop, reader.reader),
+        DownlinkPoller(session, link, cache, uploaded, stop)
+    ]
+    for stage in stages:
+        stage.start()
     
     try:
-        while True:
-            # Read line from Serial
-            if ser.in_waiting > 0:
-                line = ser.readline().decode('utf-8').strip()
-                
-                # Check if it's CSV data (contains numbers and commas)
-                if ',' in line and not line.startswith('['):
-                    current_time = time.time()
-                    
-                    # Check if enough time has passed for upload
-                    if current_time - last_upload_time >= UPDATE_INTERVAL:
-                        timestamp = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
-                        print(f"\n[{timestamp}] === NEW CYCLE ===")
-                        
-                        data = parse_csv_data(line)
-                        
-                        if data:
-                            # STEP 1: Upload to ThingSpeak
-                            print(f"  📤 UPLOADING to ThingSpeak...")
-                            print(f"     Temp={data['temperature']}°C, Humid={data['humidity']}%, Gas={data['gas_level']}, Dist={data['distance']}cm")
-                            
-                            success, message = upload_to_thingspeak(data)
-                            
-                            if success:
-                                print(f"  ✓ Upload Success (Entry: {message})")
-                                last_upload_time = current_time
-                                
-                                # STEP 2: Wait for data to be available
-                                print(f"  ⏳ Waiting {READ_DELAY} seconds for data to be available...")
-                                time.sleep(READ_DELAY)
-                                
-                                # STEP 3: Read back from ThingSpeak
-                                print(f"  📥 READING from ThingSpeak...")
-                                retrieved_data = read_from_thingspeak()
-                                
-                                if retrieved_data:
-                                    print(f"  ✓ Read Success: {' | '.join(retrieved_data)}")
-                                    
-                                    # STEP 4: Send to Arduino
-                                    print(f"  📡 Sending to Arduino...")
-                                    if send_to_arduino(ser, retrieved_data):
-                                        print(f"  ✓ Sent to Arduino successfully!")
-                                    else:
-                                        print(f"  ✗ Failed to send to Arduino")
-                                else:
-                                    print(f"  ✗ Failed to read from ThingSpeak")
-                            else:
-                                print(f"  ✗ Upload Failed: {message}")
-                        
-                    else:
-                        wait_time = UPDATE_INTERVAL - (current_time - last_upload_time)
-                        print(f"  ⏱  Next cycle in {wait_time:.0f} seconds", end='\r')
-                
-                else:
-                    # Print non-CSV lines (debug messages from Arduino)
-                    if line.strip():
-                        print(f"[Arduino] {line}")
-            
-            time.sleep(0.1)  # Small delay to prevent CPU overuse
-            
+        # The stages do the work; wake up now and then for Ctrl+C
+        while not stop.wait(1):
+            pass
+        
     except KeyboardInterrupt:
         print("\n\n✓ Program interrupted by user")
-        print("  Closing serial connection...")
         
     finally:
+        stop.set()
+        uploaded.set()  # Wake the poller so it sees the stop flag
+        for stage in stages:
+            stage.join(timeout=HTTP_TIMEOUT + 1)
+        if dashboard:
+            dashboard.stop()
+        
+        print("  Closing serial connection...")
         if ser and ser.is_open:
             ser.close()
             print("✓ Serial connection closed")
+        session.close()
+        spool.close()
         print("\nGoodbye!")
 
 # ===================================================